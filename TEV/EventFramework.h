@@ -1,29 +1,417 @@
+#if defined EFL_EVENT_QUEUE && !defined AVR
+#include <atomic>
+#endif
+#if !defined AVR
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+#if defined AVR
+#include <avr/sleep.h>
+#endif
+
 namespace efl { // event framework library
 
 /**
  * LL is a template class which adds the linked list to objects of type Item
- * which are the various Event types. It use a singly linked list to minimize
- * RAM footprint. Lists are expected to be relatively short so traversing the
- * list from the start to find the previous element it should mot take too
- * long. It uses a sentinel to point tothe first real item in the list and the
- * last item in the list points to the sentinel.
+ * which are the various Event types. It uses a sentinel to point to the first
+ * real item in the list and the last item in the list points to the sentinel.
+ *
+ * The node layout is a compile time choice:
+ *  EFL_LL_SINGLY   singly linked to minimize RAM footprint (default on AVR.)
+ *                  add() and push() are O(1) because the list tracks its tail
+ *                  but erase() and previous() scan from the head, which is
+ *                  fine while lists are short.
+ *  EFL_LL_DOUBLY   doubly linked, circular through the sentinel (default
+ *                  elsewhere.) add(), push(), erase() and previous() are all
+ *                  O(1) at the cost of one more pointer per node.
+ */
+#if !defined EFL_LL_SINGLY && !defined EFL_LL_DOUBLY
+#if defined AVR
+#define EFL_LL_SINGLY
+#else
+#define EFL_LL_DOUBLY
+#endif
+#endif
+#if defined EFL_LL_SINGLY && defined EFL_LL_DOUBLY
+#error "define at most one of EFL_LL_SINGLY and EFL_LL_DOUBLY"
+#endif
+
+/*
+ * A node records the List it is in (EFL_LL_OWNER) so that erase() and
+ * previous() without a List find it. That is a pointer more per node, 2
+ * bytes on AVR, which EFL_LL_SINGLY is there to save, so a singly linked
+ * AVR build leaves it out: there erase() and previous() without a List
+ * work on the default List, and a node on any other List must be given
+ * it. Host builds keep it either way, so the asserts catch the wrong List.
  */
+#if defined EFL_LL_DOUBLY || !defined AVR
+#define EFL_LL_OWNER
+#endif
 
 typedef unsigned long int ulong;
 typedef unsigned int uint;
 typedef unsigned char uchar;
 
-template<class Item> class LL {
+/*
+ * Trace points. EFL_TRACE(level, category, id, code) records that Item id
+ * did code, if level is no more detailed than EFL_TRACE_LEVEL and category
+ * is in the EFL_TRACE_CATEGORIES mask. Both are decided by the preprocessor,
+ * so level and category must be the EFL_TRACE_ names below. A disabled
+ * trace point expands to ((void)0) and its arguments aren't evaluated.
+ * An enabled one stores (millis(), id, code) in TraceRing, which keeps the
+ * latest EFL_TRACE_SIZE entries. Nothing is formatted until the entries
+ * are read back (TraceRing::dump() on the host.)
+ */
+#define EFL_TRACE_OFF       0       // levels
+#define EFL_TRACE_ERROR     1
+#define EFL_TRACE_INFO      2
+#define EFL_TRACE_DEBUG     3
+#define EFL_TRACE_EVENT     (1<<0)  // categories
+#define EFL_TRACE_TIMER     (1<<1)
+#define EFL_TRACE_DIGITAL   (1<<2)
+#define EFL_TRACE_ALL       0xFF
+#if !defined EFL_TRACE_LEVEL
+#define EFL_TRACE_LEVEL EFL_TRACE_OFF
+#endif
+#if !defined EFL_TRACE_CATEGORIES
+#define EFL_TRACE_CATEGORIES EFL_TRACE_ALL
+#endif
+#if !defined EFL_TRACE_SIZE     // entries kept, power of 2
+#if defined AVR
+#define EFL_TRACE_SIZE 32
+#else
+#define EFL_TRACE_SIZE 1024
+#endif
+#endif
+#if EFL_TRACE_SIZE & (EFL_TRACE_SIZE - 1)
+#error "EFL_TRACE_SIZE must be a power of 2"
+#endif
+
+#define EFL_TRACE(level, category, id, code) \
+  EFL_TRACE_IF_##level(EFL_TRACE_IF_##category(efl::TraceRing::instance().record((id), (code))))
+
+// EFL_TRACE_IF_<level or category>(x) is x when it is enabled
+#if EFL_TRACE_LEVEL >= EFL_TRACE_ERROR
+#define EFL_TRACE_IF_EFL_TRACE_ERROR(x) x
+#else
+#define EFL_TRACE_IF_EFL_TRACE_ERROR(x) ((void)0)
+#endif
+#if EFL_TRACE_LEVEL >= EFL_TRACE_INFO
+#define EFL_TRACE_IF_EFL_TRACE_INFO(x) x
+#else
+#define EFL_TRACE_IF_EFL_TRACE_INFO(x) ((void)0)
+#endif
+#if EFL_TRACE_LEVEL >= EFL_TRACE_DEBUG
+#define EFL_TRACE_IF_EFL_TRACE_DEBUG(x) x
+#else
+#define EFL_TRACE_IF_EFL_TRACE_DEBUG(x) ((void)0)
+#endif
+#if EFL_TRACE_CATEGORIES & EFL_TRACE_EVENT
+#define EFL_TRACE_IF_EFL_TRACE_EVENT(x) x
+#else
+#define EFL_TRACE_IF_EFL_TRACE_EVENT(x) ((void)0)
+#endif
+#if EFL_TRACE_CATEGORIES & EFL_TRACE_TIMER
+#define EFL_TRACE_IF_EFL_TRACE_TIMER(x) x
+#else
+#define EFL_TRACE_IF_EFL_TRACE_TIMER(x) ((void)0)
+#endif
+#if EFL_TRACE_CATEGORIES & EFL_TRACE_DIGITAL
+#define EFL_TRACE_IF_EFL_TRACE_DIGITAL(x) x
+#else
+#define EFL_TRACE_IF_EFL_TRACE_DIGITAL(x) ((void)0)
+#endif
+
+enum TraceCode {                    // what happened
+  TRACE_GOING_ACTIVE,               // Digital saw its input go active
+  TRACE_GOING_INACTIVE,             // Digital saw its input go inactive
+  TRACE_DEBOUNCED,                  // Digital debounce complete
+  TRACE_BAD_STATE                   // Digital in an unknown state, reset
+};
+
+#if EFL_TRACE_LEVEL > EFL_TRACE_OFF
+
+struct TraceEntry {
+  ulong   time;                     // millis()
+  int     id;
+  uchar   code;                     // TraceCode
+#if !defined AVR
+  uint    seq;                      // entry number + 1 once written, 0 while being written
+#endif
+};
+
+class TraceRing {
+public:
+  enum {
+    SIZE = EFL_TRACE_SIZE,
+    MASK = SIZE - 1
+  };
+  static TraceRing& instance() {
+    static TraceRing rc;
+    return rc;
+  };
+  void record(int id, uchar code) { // ISR safe on AVR, thread safe elsewhere
+#if defined AVR
+    uchar sreg = SREG;
+    cli();
+    TraceEntry* pE = &entry[head++ & MASK];
+    pE->time = millis();
+    pE->id = id;
+    pE->code = code;
+    SREG = sreg;
+#else
+    uint n = __atomic_fetch_add(&head, 1U, __ATOMIC_RELAXED);
+    TraceEntry* pE = &entry[n & MASK];
+    __atomic_store_n(&pE->seq, 0U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    pE->time = millis();
+    pE->id = id;
+    pE->code = code;
+    __atomic_store_n(&pE->seq, n + 1, __ATOMIC_RELEASE);  // publish
+#endif
+  };
+  uint size() {                     // entries held
+    return head < (uint)SIZE ? head : (uint)SIZE;
+  };
+  TraceEntry& operator[](uint i) {  // 0 is the oldest held, while nothing records
+    return entry[(head - size() + i) & MASK];
+  };
+  void clear() {
+    head = 0;
+  };
+#if !defined AVR
+  bool read(uint i, TraceEntry& e); // copy entry i, false if it is being written
+  void dump();
+#endif
 private:
-  LL* 	    pNext;          // point to next item in list
-  static LL<Item>& sentinel() {
-    static LL<Item> rc=LL<Item>((Item*)0);
+  TraceRing(): head(0) {
+  };
+  TraceEntry      entry[SIZE];
+  volatile uint   head;             // entries recorded
+};
+
+#if !defined AVR
+bool TraceRing::read(uint i, TraceEntry& e)
+{
+  uint n = head - size() + i;       // the entry's number
+  TraceEntry* pE = &entry[n & MASK];
+  if (__atomic_load_n(&pE->seq, __ATOMIC_ACQUIRE) != n + 1)
+    return false;
+  e.time = pE->time;
+  e.id = pE->id;
+  e.code = pE->code;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  e.seq = __atomic_load_n(&pE->seq, __ATOMIC_RELAXED);
+  return e.seq == n + 1;            // not overwritten meanwhile
+}
+
+void TraceRing::dump()              // skips entries being written
+{
+  TraceEntry e;
+  for (uint i = 0; i < size(); i++)
+    if (read(i, e)) {
+      co(e.time);
+      co(" ");
+      co(e.id);
+      co(" ");
+      coln((int)e.code);
+    }
+}
+#endif
+
+#endif // EFL_TRACE_LEVEL > EFL_TRACE_OFF
+
+/*
+ * Statistics. With EFL_STATS defined every List keeps log2 histograms of
+ * how late its Timers ran (in the list's clock units), how long each
+ * callback took and how long each pass took (both in EFL_STATS_CLOCK
+ * units, micros() by default) and every Timer keeps one of its own
+ * lateness. Digital callbacks run inside the state machine, so a
+ * List<Digital> only times its passes. Bucket 0 counts zeros, bucket b
+ * counts values from 2^(b-1) up to 2^b - 1 and the last bucket everything
+ * larger. Counts stop at the largest uint. Without EFL_STATS the
+ * EFL_STAT() statements compile to nothing and no space is used.
+ */
+#if defined EFL_STATS
+#define EFL_STAT(statement) statement
+#if !defined EFL_STATS_CLOCK
+#define EFL_STATS_CLOCK micros
+#endif
+#if !defined EFL_STATS_BUCKETS  // buckets per histogram
+#define EFL_STATS_BUCKETS 16
+#endif
+
+class Histogram {
+public:
+  enum {
+    BUCKETS = EFL_STATS_BUCKETS
+  };
+  Histogram() {
+    clear();
+  };
+  static uchar bucket(ulong v) {    // bucket that counts v
+    uchar b = 0;
+    for (; v && b < BUCKETS - 1; v >>= 1)
+      b++;
+    return b;
+  };
+  static ulong low(uchar b) {       // smallest value counted in bucket b
+    return b ? 1UL << (b - 1) : 0;
+  };
+  void record(ulong v) {
+    uint& c = count[bucket(v)];
+    if (c != (uint)~0U)
+      c++;
+  };
+  uint operator[](uchar b) {
+    return count[b];
+  };
+  ulong total() {
+    ulong rc = 0;
+    for (uchar b = 0; b < BUCKETS; b++)
+      rc += count[b];
     return rc;
   };
+  void clear() {
+    for (uchar b = 0; b < BUCKETS; b++)
+      count[b] = 0;
+  };
+#if !defined AVR
+  void dump(const char* name);      // name then low:count of the non empty buckets
+  void csv(const char* name);       // name then every count, comma separated
+#endif
+private:
+  uint    count[BUCKETS];
+};
+
+struct Stats {                      // per List
+  Histogram   latency;              // Timer callbacks, clock units after the deadline
+  Histogram   callback;             // EFL_STATS_CLOCK units per callback (or Timer burst)
+  Histogram   pass;                 // EFL_STATS_CLOCK units per doItems(now) pass
+  static ulong clock() {
+    return EFL_STATS_CLOCK();
+  };
+  void ran(ulong began) {           // a callback started at clock() began returned
+    callback.record(clock() - began);
+  };
+  void clear() {
+    latency.clear();
+    callback.clear();
+    pass.clear();
+  };
+#if !defined AVR
+  void dump(const char* list);      // three lines of text
+  void csv(const char* list);       // three CSV rows, see csvHeader()
+  static void csvHeader();
+#endif
+};
+
+#if !defined AVR
+void Histogram::dump(const char* name)
+{
+  co(name);
+  for (uchar b = 0; b < BUCKETS; b++)
+    if (count[b]) {
+      co(" ");
+      co(low(b));
+      co(":");
+      co(count[b]);
+    }
+  coln("");
+}
+
+void Histogram::csv(const char* name)
+{
+  co(name);
+  for (uchar b = 0; b < BUCKETS; b++) {
+    co(",");
+    co(count[b]);
+  }
+  coln("");
+}
+
+void Stats::dump(const char* list)
+{
+  co(list);
+  latency.dump(" latency");
+  co(list);
+  callback.dump(" callback");
+  co(list);
+  pass.dump(" pass");
+}
+
+void Stats::csv(const char* list)
+{
+  co(list);
+  latency.csv(",latency");
+  co(list);
+  callback.csv(",callback");
+  co(list);
+  pass.csv(",pass");
+}
+
+void Stats::csvHeader()
+{
+  co("list,histogram");
+  for (uchar b = 0; b < Histogram::BUCKETS; b++) {
+    co(",");
+    co(Histogram::low(b));
+  }
+  coln("");
+}
+#endif
+
+#else // defined EFL_STATS
+#define EFL_STAT(statement)
+#endif // defined EFL_STATS
+
+template<class Item> class LL;
+template<class Item> class List;
+class TimerBase;
+class DigitalBase;
+
+/*
+ * Hooks run when an Item joins or leaves a list. Most Item types have
+ * nothing to do here; a specialization lets a scheduler (e.g. the timing
+ * wheel) index the items it holds. Each List owns one, so any state it
+ * keeps is per list. added() is told whether push() put the Item at the
+ * front rather than add() at the end, and may refuse it by returning
+ * false, in which case add()/push() report NAK. setClock() hands over the List's
+ * clock for hooks that keep time.
+ */
+typedef ulong (*Clock)();           // millis, micros or a stand in
+
+template<class Item> struct Hooks {
+  bool added(LL<Item>*, bool) { return true; };
+  void erased(LL<Item>*) {};
+  void setClock(Clock) {};
+};
+
+#if defined EFL_FN_CALLBACKS
+/*
+ * With EFL_FN_CALLBACKS Timer's and Digital's callbacks aren't virtual, so
+ * one declared in a subclass would hide them and never run. LL's
+ * constructor checks the class of the Item it is given: for Timer and
+ * Digital (specialized below) a subclass's own callback doesn't compile.
+ */
+template<class Item> struct FnOnly {
+  template<class Derived> static void check(Derived*) {};
+};
+#endif
+
+template<class Item> class LL {
+private:
+  friend class List<Item>;
+  LL* 	    pNext;          // point to next item in list
+#if defined EFL_LL_DOUBLY
+  LL*       pPrev;          // point to previous item in list
+#endif
+#if defined EFL_LL_OWNER
+  List<Item>* pList;        // the list it is in, 0 when in none
+#endif
   Item*    pItem;                 // event descriptor
-  LL():
-  pItem((Item*)0),pNext(this) {
-  }; // can't construct w/out an Item except for the special case in sentinel()
+  LL();   // can't construct w/out an Item except for the special case of a List's sentinel
 public:
   // return status of list manipulation operations
   enum rs {
@@ -33,45 +421,201 @@ public:
   };
 
   LL(Item*pI):
-  pNext(this),pItem(pI) {
+  pNext(this),
+#if defined EFL_LL_DOUBLY
+  pPrev(this),
+#endif
+#if defined EFL_LL_OWNER
+  pList(0),
+#endif
+  pItem(pI) {
   };   // construct from an Item
-  rs add();                               // add an Item to the tail of the queue
-  rs push();                              // push an Item on to he front of the queue
+#if defined EFL_FN_CALLBACKS
+  template<class Derived> LL(Derived* pD):
+  pNext(this),
+#if defined EFL_LL_DOUBLY
+  pPrev(this),
+#endif
+#if defined EFL_LL_OWNER
+  pList(0),
+#endif
+  pItem(pD) {
+    FnOnly<Item>::check(pD);
+  };   // construct from a subclass of Item, which mustn't override its callback
+#endif
+
+  // add() and push() take the List to join; without one they join the
+  // default List for this Item type, as do the static members. With
+  // EFL_LL_OWNER a node knows the List it is in, so erase() and previous()
+  // work on that one and the List passed to them must be it.
+  rs add(List<Item>& list);               // add an Item to the tail of the queue
+  rs add() {
+    return add(List<Item>::instance());
+  };
+  rs push(List<Item>& list);              // push an Item on to he front of the queue
+  rs push() {
+    return push(List<Item>::instance());
+  };
   LL* next() {
     return pNext;
   };              // return pointer to next iutem in list
-  LL* previous();                         // pointer to previous item in list
+  Item* item() {
+    return pItem;
+  };              // Item bound to this node
+  LL* previous(List<Item>& list);         // pointer to previous item in list
+  LL* previous() {
+#if defined EFL_LL_OWNER
+    return previous(pList ? *pList : List<Item>::instance());
+#else
+    return previous(List<Item>::instance());
+#endif
+  };
+  LL* erase(List<Item>& list);            // remove this item from the list
+  LL* erase() {
+#if defined EFL_LL_OWNER
+    return erase(pList ? *pList : List<Item>::instance());
+#else
+    return erase(List<Item>::instance());
+#endif
+  };
   static LL* begin() {
-    return sentinel().pNext;
+    return List<Item>::instance().begin();
   };   // pointer to first item in list (past the sentinel)
   static LL* end() {
-    return &sentinel();
+    return List<Item>::instance().end();
   };  // pointer to end of list (e.g. the sentinel)
-  LL* erase();                            // remove this item from the list
   static int& size() {
-    static int elementCount=0;
-    return elementCount;
+    return List<Item>::instance().size();
+  };
+  static void doItems() {
+    List<Item>::instance().doItems();
+  };
+
+#if !defined AVR
+  static void walk() {
+    List<Item>::instance().walk();
+  };
+#endif
+};
+
+/*
+ * List owns what a list of LL<Item> needs: the sentinel, the count, the
+ * time of the previous pass and the per list Hooks. A program can have as
+ * many Lists of a kind as it likes (e.g. one per simulated board); the
+ * static LL API works on List<Item>::instance().
+ *
+ * Each List reads its own clock, millis() unless it is constructed with
+ * another, and all its times are in that clock's units. A List<Timer> on
+ * micros() runs its Timers' counters, periods and lateness in microseconds.
+ * Times are compared as differences, so the clock may wrap (micros() does
+ * every 71 minutes on AVR.)
+ */
+template<class Item> class List {
+private:
+  friend class LL<Item>;
+  LL<Item>    sentinel;             // points to the first item, the last points back to it
+#if defined EFL_LL_SINGLY
+  LL<Item>*   pTail;                // last item in the list (the sentinel when empty)
+#endif
+  int         count;                // items in the list
+  ulong       prevMillis;           // clock at the previous pass (Timer, Digital)
+  Clock       pClock;               // the list's time base
+  List(const List&);                // the sentinel is self referencing, no copies
+  List& operator=(const List&);
+  bool onePass(ulong now);    // doItems(now) without the statistics
+  // the generic pass and idleFor() by the kind of Item: Event's rule, the
+  // Timer down count or the Digital poll (see StaticTimer, StaticDigital)
+  bool onePass(ulong now, const void*);
+  bool onePass(ulong now, TimerBase*);
+  bool onePass(ulong now, DigitalBase*);
+  ulong idleFor(ulong now, ulong limit, const void*);
+  ulong idleFor(ulong now, ulong limit, TimerBase*);
+  ulong idleFor(ulong now, ulong limit, DigitalBase*);
+  static bool timed(const void*) {
+    return false;
+  };
+  static bool timed(TimerBase*) {
+    return true;
+  };
+  static bool timed(DigitalBase*) {
+    return true;
+  };
+public:
+  Hooks<Item> hooks;
+#if defined EFL_STATS
+  Stats       stats;
+#endif
+
+  explicit List(Clock clock = millis):
+  sentinel((Item*)0),
+#if defined EFL_LL_SINGLY
+  pTail(&sentinel),
+#endif
+  count(0),prevMillis(0),pClock(clock) {
+    hooks.setClock(clock);
+  };
+  static List& instance() {
+    static List rc;
+    return rc;
+  };  // the default list
+  LL<Item>* begin() {
+    return sentinel.pNext;
+  };
+  LL<Item>* end() {
+    return &sentinel;
+  };
+  int& size() {
+    return count;
+  };
+  ulong now() {
+    return pClock();
+  };                          // read the list's clock
+  ulong now(ulong ms) {
+    return pClock == millis ? ms : pClock();
+  };                          // the list's time in a pass that read millis() as ms
+  Clock clock() {
+    return pClock;
+  };
+  void doItems();             // one pass, reading the clock if the Item needs it
+  bool doItems(ulong now) {   // one pass at clock time now, true if any work was done
+    EFL_STAT(ulong began = Stats::clock());
+    bool work = onePass(now); // generic below, Event, Timer and Digital provide their own
+    EFL_STAT(stats.pass.record(Stats::clock() - began));
+    return work;
+  };
+  ulong idleFor(ulong now, ulong limit);  // ms until a pass is needed, at most limit
+  ulong settleFor(ulong now, ulong limit) {
+    return idleFor(now, limit);
+  };                          // the same if no input changes meanwhile (Digital differs)
+  bool woken() {              // work arrived from an ISR (see Idle)
+    return false;
   };
-  static void doItems();      // each specialization expected to provide their own 'doItems()'
 
 #if !defined AVR
-  static void walk();
+  void walk();
 #endif
 };
 
 template<class Item>
-typename LL<Item>::rs LL<Item>::add() {
-  if( this == end())            // this would be bad!
+typename LL<Item>::rs LL<Item>::add(List<Item>& list) {
+  if( this == list.end())       // this would be bad!
     return BAD_DUP;
   if (pNext == this) {                // should be point to itself right now
-    LL<Item>* pLL = LL<Item>::sentinel().pNext; // point to head of list
-
-      while (pLL->pNext != &LL<Item>::sentinel()) // Does this one point toward the sentinel (i.e. end of list)
-      pLL = pLL->pNext;
-
-    pLL->pNext = this;              // make end of list point to the one to add
-    pNext = &LL<Item>::sentinel();     // and now mark it as the new end of the list
-    size()++;
+    if (!list.hooks.added(this, false))
+      return LL<Item>::NAK;
+#if defined EFL_LL_DOUBLY
+    pPrev = list.sentinel.pPrev;    // the sentinel's predecessor is the tail
+    pPrev->pNext = this;
+    list.sentinel.pPrev = this;
+#else
+    list.pTail->pNext = this;       // make end of list point to the one to add
+    list.pTail = this;
+#endif
+    pNext = list.end();             // and now mark it as the new end of the list
+#if defined EFL_LL_OWNER
+    pList = &list;
+#endif
+    list.count++;
     return LL<Item>::OK;
   } 
   else {
@@ -80,42 +624,64 @@ typename LL<Item>::rs LL<Item>::add() {
 }
 
 template<class Item>
-typename LL<Item>::rs LL<Item>::push()
+typename LL<Item>::rs LL<Item>::push(List<Item>& list)
 {
-  if( this != pNext ) // already in the list
+  if( this == list.end() || this != pNext ) // sentinel or already in the list
     return BAD_DUP;
-  pNext = sentinel().pNext;
-  sentinel().pNext = this;
-  size()++;
+  if (!list.hooks.added(this, true))
+    return NAK;
+  pNext = list.sentinel.pNext;
+  list.sentinel.pNext = this;
+#if defined EFL_LL_DOUBLY
+  pPrev = list.end();
+  pNext->pPrev = this;
+#else
+  if (pNext == list.end())
+    list.pTail = this;
+#endif
+#if defined EFL_LL_OWNER
+  pList = &list;
+#endif
+  list.count++;
   return OK;
 }
 
 
 template<class Item>
-LL<Item>* LL<Item>::previous()
+LL<Item>* LL<Item>::previous(List<Item>& list)
 {
-  LL<Item>* pLL = begin();
-  while(pLL != end())
+#if defined EFL_LL_DOUBLY
+  if (this != list.end() && pNext == this)  // not in the list
+    return list.end();
+  assert(!pList || pList == &list);
+  return pPrev;
+#else
+#if defined EFL_LL_OWNER
+  assert(!pList || pList == &list);
+#endif
+  LL<Item>* pLL = list.begin();
+  while(pLL != list.end())
     if(pLL->next() == this)
       return pLL;
     else
       pLL = pLL->next();
   return pLL;
+#endif
 }
 
 #if !defined AVR
 
 template<class Item>
-void LL<Item>::walk()
+void List<Item>::walk()
 {
   coln("");
   co("walk(");
   co(size());
   co(") ");
-  LL<Item>*  pLL = LL<Item>::sentinel().pNext;
-  co( (void*)&sentinel() );
+  LL<Item>*  pLL = begin();
+  co( (void*)end() );
   co( " -> ");
-  while( pLL != &LL<Item>::sentinel() )
+  while( pLL != end() )
   {
     co( pLL);
     co( " -> ");
@@ -128,280 +694,2631 @@ void LL<Item>::walk()
 #endif
 
 template<class Item>
-LL<Item>* LL<Item>::erase()
+LL<Item>* LL<Item>::erase(List<Item>& from)
 {
-  if( this == pNext )                           // marked as not in list?
-    return begin();                           // does anything else make sense here? This should be safe for the caller.
-  LL<Item>*  pLL = &LL<Item>::sentinel();       // start at the head end of the list
-  while( pLL->pNext != &LL<Item>::sentinel() )  // and iterate until we've gone through the list (should never happen!
+  if( this == pNext || this == from.end() )     // marked as not in list?
+    return from.begin();                      // does anything else make sense here? This should be safe for the caller.
+#if defined EFL_LL_OWNER
+  assert(pList == &from);                     // erase from the list it is in
+  pList = 0;
+#endif
+  List<Item>& list = from;
+#if defined EFL_LL_DOUBLY
+  LL<Item>*  pLL = pNext;
+  pPrev->pNext = pNext;
+  pNext->pPrev = pPrev;
+  pNext = pPrev = this;
+  list.count--;
+  list.hooks.erased(this);
+  return pLL;
+#else
+  LL<Item>*  pLL = list.end();                  // start at the head end of the list
+  while( pLL->pNext != list.end() )             // and iterate until we've gone through the list (should never happen!
   {
     if( this == pLL->pNext )
     {
       pLL->pNext = pNext;
+      if( list.pTail == this )
+        list.pTail = pLL;
       pNext = this;
-      size()--;
+      list.count--;
+      list.hooks.erased(this);
       return pLL->pNext;
     }
     pLL = pLL->pNext;
   }
   assert(0);
   return pLL->pNext;      // should never get here
+#endif
+}
+
+/*
+ * The pass for Item types without a doItems() of their own. Any class with
+ * a bool callback() can be listed and is run by Event's rule: false and it
+ * leaves the list, true and it stays for the next pass. The call is bound
+ * at compile time, so when callback() isn't virtual the class needs no
+ * vtable and the compiler may inline it into the pass. Such Items aren't
+ * timed, so the pass doesn't read the clock. Items derived from TimerBase
+ * or DigitalBase are run as Timers and Digitals instead.
+ */
+template<class Item>
+bool List<Item>::onePass(ulong now)
+{
+  return onePass(now, (Item*)0);  // picked by the Item's base
+}
+
+template<class Item>
+bool List<Item>::onePass(ulong, const void*)
+{
+  if(!count)
+    return false;
+  for(LL<Item>* pLL = begin(); pLL != end(); ) {
+    EFL_STAT(ulong began = Stats::clock());
+    bool again = pLL->pItem->callback();
+    EFL_STAT(stats.ran(began));
+    if(!again)
+      pLL = pLL->erase(*this);    // remove from list
+    else
+      pLL = pLL->next();          // stays for the next pass
+  }
+  return true;
+}
+
+template<class Item>
+void List<Item>::doItems()
+{
+  doItems(timed((Item*)0) ? now() : 0UL);   // untimed Items don't use it
+}
+
+template<class Item>
+ulong List<Item>::idleFor(ulong now, ulong limit)
+{
+  return idleFor(now, limit, (Item*)0);
+}
+
+template<class Item>
+ulong List<Item>::idleFor(ulong, ulong limit, const void*)
+{
+  return count ? 0 : limit;       // anything listed runs on every pass
 }
 
 /*
  * Generic Event - one can just chain a bunch of these together and
  * execute them. Not very interesting but the simplest case.
+ *
+ * With EFL_EVENT_PRIORITY each Event has a priority class, 0 (the default)
+ * up to EFL_EVENT_PRIORITIES - 1, and a List<Event> pass runs the higher
+ * classes first. Within a class Events run in the order they were added.
+ * hooks.budget (EFL_EVENT_BUDGET, default 0 for no limit) caps the
+ * callbacks of one pass. A pass that runs out picks up the next one where
+ * it stopped, after any higher class, so repeating Events can't hold up
+ * the Timers and inputs run beside them for more than budget callbacks.
  */
+#if defined EFL_EVENT_PRIORITY
+#if !defined EFL_EVENT_PRIORITIES
+#define EFL_EVENT_PRIORITIES 4
+#endif
+#if !defined EFL_EVENT_BUDGET
+#define EFL_EVENT_BUDGET 0
+#endif
+#endif
+
 class Event { // callback makes this a one shot event (won't execute until it is added back to the list.)
 public:
 
-  Event() {
+  Event()
+#if defined EFL_EVENT_PRIORITY
+  :priority(0),pNextP(0),ppPrevP(0)
+#endif
+  {
   };
   virtual bool callback() {
     if (verbose) coln( "Event:");
     return false;
   };
+#if defined EFL_EVENT_PRIORITY
+  uchar getPriority() {
+    return priority;
+  };
+  void setPriority(uchar p) {   // while not in a list
+    priority = p < EFL_EVENT_PRIORITIES ? p : EFL_EVENT_PRIORITIES - 1;
+  };
+#endif
   virtual ~Event(){} // virtual destructor to quash warnings
+#if defined EFL_EVENT_PRIORITY
+private:
+  friend struct Hooks<Event>;
+  friend class List<Event>;
+  uchar         priority;
+  LL<Event>*    pNextP;         // next in the same class
+  LL<Event>**   ppPrevP;        // link that points to this one, 0 while running
+#endif
 };
 
-template<>
-void LL<Event>::doItems()
-{
-  for(LL<Event>* pLL = begin(); pLL != end(); )
-    if(!pLL->pItem->callback())
-      pLL = pLL->erase();         // remove from list
-}
-
-
 /*
- * Timer class gets a little more interesting. The default behavior
- * is a one shot but given a non-zero period will be periodic.
- *
+ * FnEvent calls a plain function instead of a virtual one, so Events with
+ * different callbacks can share a List<FnEvent> without a vtable. The
+ * function gets the FnEvent; derive from it to carry the context.
  */
-class Timer {
-private:
-  ulong   counter;
-  ulong   period;
+class FnEvent {
 public:
-  Timer(ulong c=1, ulong p=0):
-  counter(c),period(p) {
-  }; // default to fire once after 1 ms
-  virtual bool callback(ulong late) {
-    if (verbose) {
-      coln( "Timer:");
-    }
-    return false;
+  typedef bool (*Fn)(FnEvent* pE);
+  explicit FnEvent(Fn fn):
+  pFn(fn) {
   };
-  ulong getCounter() {
-    return counter;
-  }
-  void setCounter(ulong c) {
-    counter=c;
-  }
-  ulong getPeriod() {
-    return period;
-  }
-  void setPeriod(ulong p) {
-    period=p;
-  }
-  virtual ~Timer(){}; // virtual destructor to quash warnings
+  bool callback() {
+    return pFn(this);
+  };
+private:
+  Fn    pFn;
 };
 
-template<>
-void LL<Timer>::doItems()
-{
-  static ulong prevMillis = 0;    // start when execution starts
-  ulong   nowMillis = millis();   // time now
-  ulong   deltaMillis = nowMillis - prevMillis;
-
-  if(!deltaMillis)
-    return;
+/*
+ * EventPool keeps up to N Items (N < 255) in one array and links them with
+ * one byte indices instead of LL nodes, so each Item costs a byte of list
+ * overhead and a pass walks contiguous memory. add() takes a free slot,
+ * appends it to the run list and returns the Item to set up (0 when the
+ * pool is full.) doItems() runs the Items by Event's rule and an Item
+ * whose callback() returns false goes back to the free slots. Slots are
+ * default constructed once and reused as they are. A callback may add()
+ * but must not erase() another Item.
+ *
+ * A pool is a scheduler of its own, not a List: run() and EventLoop::tick()
+ * don't run it and Idle doesn't wait for it. Call its doItems() beside them
+ * and hand its idleFor() to sleep() as the limit, e.g.
+ * idle.sleep(pool.idleFor(millis(), ~0UL)).
+ */
+template<class Item, uint N> class EventPool {
+public:
+  EventPool():
+  head(END),tail(END),spare(0),count(0) {
+    for (uint i = 0; i < N; i++)
+      link[i] = (i + 1 < N) ? i + 1 : (uint)END;
+  };
+  Item* add();                      // to the tail of the run list
+  bool erase(Item* pItem);          // back to the free slots
+  bool doItems();                   // true if any Item ran
+  ulong idleFor(ulong, ulong limit) {
+    return count ? 0 : limit;       // anything in the pool runs on every pass
+  };
+  uint size() {
+    return count;
+  };
+  static uint capacity() {
+    return N;
+  };
+  Item* first() {                   // walk the run list, 0 at the end
+    return head == END ? 0 : &items[head];
+  };
+  Item* next(Item* pItem) {
+    uchar i = link[pItem - items];
+    return i == END ? 0 : &items[i];
+  };
+
+private:
+  enum {
+    END = 0xFF
+  };
+  typedef char capacityCheck[(N > 0 && N < END) ? 1 : -1];
+  void unlink(uchar i, uchar prev); // i follows prev (END for the head)
+  EventPool(const EventPool&);
+  EventPool& operator=(const EventPool&);
+
+  Item    items[N];
+  uchar   link[N];                  // next slot in the run list or in the free list
+  uchar   head;                     // first and last of the run list
+  uchar   tail;
+  uchar   spare;                    // first free slot
+  uchar   count;                    // Items in the run list
+};
+
+template<class Item, uint N>
+Item* EventPool<Item, N>::add()
+{
+  if (spare == END)
+    return 0;
+  uchar i = spare;
+  spare = link[i];
+  link[i] = END;
+  if (tail == END)
+    head = i;
+  else
+    link[tail] = i;
+  tail = i;
+  count++;
+  return &items[i];
+}
+
+template<class Item, uint N>
+void EventPool<Item, N>::unlink(uchar i, uchar prev)
+{
+  if (prev == END)
+    head = link[i];
+  else
+    link[prev] = link[i];
+  if (tail == i)
+    tail = prev;
+  link[i] = spare;
+  spare = i;
+  count--;
+}
+
+template<class Item, uint N>
+bool EventPool<Item, N>::erase(Item* pItem)
+{
+  uchar prev = END;
+  for (uchar i = head; i != END; prev = i, i = link[i])
+    if (&items[i] == pItem) {
+      unlink(i, prev);
+      return true;
+    }
+  return false;                     // not in the run list
+}
+
+template<class Item, uint N>
+bool EventPool<Item, N>::doItems()
+{
+  if (!count)
+    return false;
+  uchar prev = END;
+  for (uchar i = head; i != END; ) {
+    uchar next = link[i];
+    if (items[i].callback())
+      prev = i;                     // stays for the next pass
+    else
+      unlink(i, prev);
+    i = next;
+  }
+  return true;
+}
+
+#if !defined AVR
+/*
+ * Wakeup ends an Idle::sleep() on the host early. post() and pinChanged()
+ * raise it from any thread; sleep() waits on it for at most the time the
+ * lists allow, in real time. Raises are counted rather than latched: a
+ * sleep takes the count before it checks its lists and waits for it to
+ * move, so a raise between that check and the wait ends the wait at once,
+ * while one that came before the check (whose work the check sees) ends
+ * no later sleep. Any number of threads may sleep on it.
+ */
+class Wakeup {
+public:
+  static Wakeup& instance() {
+    static Wakeup rc;
+    return rc;
+  };
+  void raise() {
+    std::lock_guard<std::mutex> l(lock);
+    raised++;
+    cv.notify_all();
+  };
+  ulong raises() {                  // the count to hand wait()
+    std::lock_guard<std::mutex> l(lock);
+    return raised;
+  };
+  void wait(ulong ms, ulong seen) { // until raised after seen or ms have passed
+    std::unique_lock<std::mutex> l(lock);
+    if (ms < 1UL << 31) {
+      std::chrono::steady_clock::time_point until =
+          std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+      while (raised == seen && cv.wait_until(l, until) != std::cv_status::timeout)
+        ;
+    }
+    else                            // no limit worth a deadline
+      while (raised == seen)
+        cv.wait(l);
+  };
+private:
+  Wakeup(): raised(0) {
+  };
+  std::mutex              lock;
+  std::condition_variable cv;
+  ulong                   raised;   // raise()s so far
+};
+#endif
+
+#if defined EFL_EVENT_QUEUE
+
+#if !defined EFL_QUEUE_SIZE     // events that can be waiting to be added, power of 2
+#if defined AVR
+#define EFL_QUEUE_SIZE 8
+#else
+#define EFL_QUEUE_SIZE 256
+#endif
+#endif
+#if EFL_QUEUE_SIZE & (EFL_QUEUE_SIZE - 1)
+#error "EFL_QUEUE_SIZE must be a power of 2"
+#endif
+#if defined AVR && EFL_QUEUE_SIZE > 128
+#error "EFL_QUEUE_SIZE must be at most 128 on AVR (one byte ring indices)"
+#endif
+
+/*
+ * EventQueue lets an interrupt handler or another thread hand an Event to a
+ * List<Event> without touching the list itself: post() only writes a slot
+ * in a bounded ring and List<Event>::doItems() adds whatever was posted at
+ * the start of its next pass. post() returns false when the ring is full.
+ *
+ * On AVR the ring is single consumer and post() masks interrupts for the
+ * few instructions it takes, so it may be called from any ISR as well as
+ * from loop(). Elsewhere it is a lock free multi producer ring (after
+ * Dmitry Vyukov's bounded queue): each slot carries a sequence number that
+ * tells producers and the consumer whose turn it is.
+ */
+class EventQueue {
+public:
+  enum {
+    SIZE = EFL_QUEUE_SIZE,
+    MASK = SIZE - 1
+  };
+#if defined AVR
+  EventQueue(): head(0), tail(0) {
+  };
+  bool post(LL<Event>* pLL) {
+    uchar sreg = SREG;
+    cli();
+    bool ok = (uchar)(head - tail) < SIZE;
+    if (ok)
+      slot[head++ & MASK] = pLL;
+    SREG = sreg;
+    return ok;
+  };
+  bool pending() {                  // something to take
+    return head != tail;
+  };
+  bool take(LL<Event>*& pLL) {      // consumer only
+    if (head == tail)               // one byte read, no need to mask
+      return false;
+    asm volatile("" ::: "memory");  // read the slot after head, not before
+    pLL = slot[tail & MASK];
+    tail++;
+    return true;
+  };
+private:
+  LL<Event>*      slot[SIZE];
+  volatile uchar  head;             // next slot to post to (producers)
+  uchar           tail;             // next slot to take from (consumer)
+#else
+  EventQueue(): head(0), tail(0) {
+    for (uint i = 0; i < SIZE; i++)
+      slot[i].seq.store(i, std::memory_order_relaxed);
+  };
+  bool post(LL<Event>* pLL) {
+    uint pos = head.load(std::memory_order_relaxed);
+    Slot* pS;
+    for (;;) {
+      pS = &slot[pos & MASK];
+      int diff = (int)(pS->seq.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {              // free, try to claim it
+        if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)            // consumer hasn't freed it yet, full
+        return false;
+      else                          // another producer got there first
+        pos = head.load(std::memory_order_relaxed);
+    }
+    pS->pLL = pLL;
+    pS->seq.store(pos + 1, std::memory_order_release);
+    Wakeup::instance().raise();
+    return true;
+  };
+  bool pending() {                  // something to take
+    return (int)(slot[tail & MASK].seq.load(std::memory_order_acquire) - (tail + 1)) >= 0;
+  };
+  bool take(LL<Event>*& pLL) {      // consumer only
+    Slot* pS = &slot[tail & MASK];
+    if ((int)(pS->seq.load(std::memory_order_acquire) - (tail + 1)) < 0)
+      return false;
+    pLL = pS->pLL;
+    pS->seq.store(tail + SIZE, std::memory_order_release);
+    tail++;
+    return true;
+  };
+private:
+  struct Slot {
+    std::atomic<uint>   seq;
+    LL<Event>*          pLL;
+  };
+  Slot                slot[SIZE];
+  std::atomic<uint>   head;         // next position to post to (producers)
+  uint                tail;         // next position to take from (consumer)
+#endif
+};
+
+#endif // defined EFL_EVENT_QUEUE
+
+#if defined EFL_EVENT_QUEUE || defined EFL_EVENT_PRIORITY
+
+template<> struct Hooks<Event> {
+#if defined EFL_EVENT_QUEUE
+  EventQueue inbox;                 // posted to this list, not yet added
+#endif
+#if defined EFL_EVENT_PRIORITY
+  enum {
+    PRIORITIES = EFL_EVENT_PRIORITIES
+  };
+  LL<Event>*      ready[PRIORITIES];    // each class, next to run first
+  LL<Event>**     ppLast[PRIORITIES];   // the link to append at
+  uint            budget;               // callbacks per pass, 0 for no limit
+  Hooks(): budget(EFL_EVENT_BUDGET) {
+    for (uchar p = 0; p < PRIORITIES; p++) {
+      ready[p] = 0;
+      ppLast[p] = &ready[p];
+    }
+  };
+  bool added(LL<Event>* pLL, bool front) {
+    if (front)
+      prepend(pLL);
+    else
+      append(pLL);
+    return true;
+  };
+  void erased(LL<Event>* pLL) {
+    if (pLL->item()->ppPrevP)       // not the one running
+      unlink(pLL);
+  };
+  void append(LL<Event>* pLL) {     // at the end of its class
+    Event* pE = pLL->item();
+    pE->pNextP = 0;
+    pE->ppPrevP = ppLast[pE->priority];
+    *ppLast[pE->priority] = pLL;
+    ppLast[pE->priority] = &pE->pNextP;
+  };
+  void prepend(LL<Event>* pLL) {    // at the front of its class
+    Event* pE = pLL->item();
+    LL<Event>** ppFirst = &ready[pE->priority];
+    pE->pNextP = *ppFirst;
+    pE->ppPrevP = ppFirst;
+    if (*ppFirst)
+      (*ppFirst)->item()->ppPrevP = &pE->pNextP;
+    else
+      ppLast[pE->priority] = &pE->pNextP;
+    *ppFirst = pLL;
+  };
+  void unlink(LL<Event>* pLL) {     // from its class or a detached run of it
+    Event* pE = pLL->item();
+    *pE->ppPrevP = pE->pNextP;
+    if (pE->pNextP)
+      pE->pNextP->item()->ppPrevP = pE->ppPrevP;
+    else if (ppLast[pE->priority] == &pE->pNextP)
+      ppLast[pE->priority] = pE->ppPrevP;
+    pE->pNextP = 0;
+    pE->ppPrevP = 0;
+  };
+#else
+  bool added(LL<Event>*, bool) { return true; };
+  void erased(LL<Event>*) {};
+#endif
+  void setClock(Clock) {};
+};
+
+#endif // defined EFL_EVENT_QUEUE || defined EFL_EVENT_PRIORITY
+
+#if defined EFL_EVENT_QUEUE
+
+// hand pLL to list from an ISR or another thread; it is added on the next pass
+inline bool post(LL<Event>* pLL, List<Event>& list = List<Event>::instance())
+{
+  return list.hooks.inbox.post(pLL);
+}
+
+template<>
+ulong List<Event>::idleFor(ulong, ulong limit)
+{
+  return (count || hooks.inbox.pending()) ? 0 : limit;
+}
+
+template<>
+bool List<Event>::woken()
+{
+  return hooks.inbox.pending();
+}
+
+#endif // defined EFL_EVENT_QUEUE
+
+template<>
+bool List<Event>::onePass(ulong)
+{
+#if defined EFL_EVENT_QUEUE
+  LL<Event>* pPosted;             // at most one ring full per pass
+  for (uint n = 0; n < EventQueue::SIZE && hooks.inbox.take(pPosted); n++)
+    pPosted->add(*this);          // BAD_DUP if it was already queued
+#endif
+  if(!count)
+    return false;
+#if defined EFL_EVENT_PRIORITY
+  uint  ran = 0;
+  for (uchar p = Hooks<Event>::PRIORITIES; p-- > 0; ) {
+    // detach the class so callbacks can add and erase Events freely; those
+    // that stay go back on the end, after any added meanwhile
+    LL<Event>* pending = hooks.ready[p];
+    if (!pending)
+      continue;
+    hooks.ready[p] = 0;
+    hooks.ppLast[p] = &hooks.ready[p];
+    pending->item()->ppPrevP = &pending;
+    while (pending && (!hooks.budget || ran < hooks.budget)) {
+      LL<Event>*  pLL = pending;
+      hooks.unlink(pLL);
+      ran++;
+      EFL_STAT(ulong began = Stats::clock());
+      bool again = pLL->pItem->callback();
+      EFL_STAT(stats.ran(began));
+      if (!again)
+        pLL->erase(*this);        // remove from list
+      else if (pLL->next() != pLL && !pLL->item()->ppPrevP)
+        hooks.append(pLL);        // unless the callback erased or re-added it
+    }
+    if (pending) {                // out of budget, the rest go first next pass
+      LL<Event>* pLast = pending;
+      while (pLast->item()->pNextP)
+        pLast = pLast->item()->pNextP;
+      pLast->item()->pNextP = hooks.ready[p];
+      if (hooks.ready[p])
+        hooks.ready[p]->item()->ppPrevP = &pLast->item()->pNextP;
+      else
+        hooks.ppLast[p] = &pLast->item()->pNextP;
+      hooks.ready[p] = pending;
+      pending->item()->ppPrevP = &hooks.ready[p];
+      break;
+    }
+  }
+#else
+  for(LL<Event>* pLL = begin(); pLL != end(); ) {
+    EFL_STAT(ulong began = Stats::clock());
+    bool again = pLL->pItem->callback();
+    EFL_STAT(stats.ran(began));
+    if(!again)
+      pLL = pLL->erase(*this);    // remove from list
+    else
+      pLL = pLL->next();          // stays for the next pass
+  }
+#endif
+  return true;
+}
+
+/*
+ * Channel<T, N> hands T payloads from a producer to any number of
+ * Subscriber<T>s. The producer claim()s a slot, fills it in place and
+ * publish()es it; the Channel, itself an Event, then delivers it on the
+ * next pass of its List<Event>, calling every subscriber with a reference
+ * to the same slot, oldest payload first. Nothing is copied or allocated.
+ * A slot is free again once every subscriber has had it, so N bounds the
+ * payloads waiting; claim() returns 0 when they are all waiting.
+ * Subscribers are listed through LL<Subscriber<T> > nodes, by Event's
+ * rule: a callback that returns false unsubscribes.
+ */
+template<class T> class Subscriber {
+public:
+  virtual bool callback(const T& payload) = 0;
+  virtual ~Subscriber() {};
+};
+
+template<class T, uchar N = 4> class Channel:
+  public Event {
+public:
+  explicit Channel(List<Event>& events = List<Event>::instance()):
+  node(this),events(events),oldest(0),waiting(0) {
+  };
+  List<Subscriber<T> >& subscribers() {
+    return subs;
+  };
+  T* claim() {                      // the slot to fill, 0 if none is free
+    return waiting < N ? &slot[(oldest + waiting) % N] : 0;
+  };
+  bool publish() {                  // deliver the claimed slot, false if none was free
+    if (waiting >= N)
+      return false;
+    waiting++;
+    node.add(events);               // BAD_DUP if a delivery is already due
+    return true;
+  };
+  uchar pending() {                 // published but not yet delivered
+    return waiting;
+  };
+  virtual bool callback();
+private:
+  LL<Event>             node;       // on events while a delivery is due
+  List<Event>&          events;
+  List<Subscriber<T> >  subs;
+  T                     slot[N];
+  uchar                 oldest;     // the next to deliver
+  uchar                 waiting;
+};
+
+template<class T, uchar N>
+bool Channel<T, N>::callback()
+{
+  for (uchar n = waiting; n; n--) { // those published during delivery wait a pass
+    for (LL<Subscriber<T> >* pLL = subs.begin(); pLL != subs.end(); )
+      if (!pLL->item()->callback(slot[oldest]))
+        pLL = pLL->erase(subs);     // unsubscribe
+      else
+        pLL = pLL->next();
+    oldest = (oldest + 1) % N;
+    waiting--;
+  }
+  return waiting != 0;
+}
+
+/*
+ * CountedEvent coalesces a burst: raise() it any number of times between
+ * passes of its List<Event> and coalesced() runs once, told how many
+ * times it was raised. Adding a plain Event that is already listed just returns
+ * BAD_DUP and the repeat is lost. LatestEvent<T> also keeps the value of
+ * the latest raise(), copied into its slot, and hands it to latest(). As
+ * with any Event, a callback
+ * that returns true stays listed, and then runs every pass with the raises
+ * since the previous one (possibly 0). raise() is for the main context; an
+ * ISR should post() an Event instead.
+ */
+class CountedEvent:
+  public Event {
+public:
+  explicit CountedEvent(List<Event>& events = List<Event>::instance()):
+  node(this),events(events),raised(0) {
+  };
+  void raise() {
+    if (raised != (uint)~0U)
+      raised++;
+    node.add(events);               // BAD_DUP if it is already due
+  };
+  uint getRaised() {                // since the last callback
+    return raised;
+  };
+  virtual bool coalesced(uint count) {
+    if (verbose) coln( "CountedEvent:");
+    return false;
+  };
+  virtual bool callback() {
+    uint n = raised;
+    raised = 0;
+    return coalesced(n);
+  };
+private:
+  LL<Event>     node;
+  List<Event>&  events;
+  uint          raised;
+};
+
+template<class T> class LatestEvent:
+  public CountedEvent {
+public:
+  explicit LatestEvent(List<Event>& events = List<Event>::instance()):
+  CountedEvent(events),last() {
+  };
+  void raise(const T& value) {
+    last = value;
+    CountedEvent::raise();
+  };
+  virtual bool latest(const T& value, uint count) {
+    if (verbose) coln( "LatestEvent:");
+    return false;
+  };
+  virtual bool coalesced(uint count) {
+    return latest(last, count);
+  };
+private:
+  T             last;
+};
+
+
+/*
+ * Timer class gets a little more interesting. The default behavior
+ * is a one shot but given a non-zero period will be periodic.
+ *
+ * By default LL<Timer>::doItems() down counts every registered timer on
+ * each pass. Define EFL_TIMER_WHEEL before including this file to have the
+ * timers held in a hierarchical timing wheel keyed by absolute deadline
+ * instead, so a pass only touches the timers that expire. EFL_TIMER_HEAP
+ * holds them in a binary heap ordered by deadline, which also tells the
+ * caller how long it may sleep (TimerHeap::nextDeadline().)
+ *
+ * With EFL_FN_CALLBACKS, Timer and Digital have no virtual functions and
+ * so no vtable pointer. Each calls the plain function given to its
+ * constructor instead, the way FnEvent does. The function gets the Timer
+ * or Digital; derive from it to carry the context. A subclass that
+ * declares its own callback() doesn't compile in this mode (see FnOnly.)
+ * The schedulers and the Digital engines work on the base classes either
+ * way. The stored function is no smaller than a vtable pointer and can't
+ * be inlined; StaticTimer and StaticDigital below are the way to both.
+ */
+#if defined EFL_TIMER_WHEEL && defined EFL_TIMER_HEAP
+#error "define at most one of EFL_TIMER_WHEEL and EFL_TIMER_HEAP"
+#endif
+#if defined EFL_TIMER_WHEEL
+class TimerWheel;
+typedef TimerWheel TimerScheduler;
+#elif defined EFL_TIMER_HEAP
+class TimerHeap;
+typedef TimerHeap TimerScheduler;
+#endif
+#if defined EFL_TIMER_WHEEL || defined EFL_TIMER_HEAP
+#define EFL_TIMER_DEADLINE      // timers are scheduled by absolute deadline
+#endif
+
+/*
+ * TimerBase holds what every timer has: the count, the period and the
+ * catch up policy. expire() applies the policy and calls back through the
+ * type it is given, so the call is bound at compile time when that type
+ * is known. Timer adds the schedulers' links and the callback, virtual or
+ * (EFL_FN_CALLBACKS) a stored function. StaticTimer<Derived> adds no more
+ * than TimerBase: a List<Derived> of them is down counted like the
+ * default List<Timer> and calls Derived::callback() directly, so it can
+ * be inlined and the Timer needs neither a vtable nor a function pointer.
+ */
+class TimerBase {
+public:
+  typedef enum {          /// what a periodic timer does when it fires late
+    RELATIVE,             // next deadline a period after the one it ran for,
+                          // or 1 ms from now if a whole period was missed (default)
+    SKIP,                 // fixed rate: run once for the latest deadline due and
+                          // drop the missed ones, the deadlines stay on the grid
+    BURST,                // fixed rate: run once for each deadline due
+    COALESCE              // fixed rate: run once, told how many deadlines were missed
+  } CatchUp;
+
+protected:
+  ulong   counter;
+  ulong   period;
+  uchar   catchUp;        // CatchUp
+#if defined EFL_STATS
+  Histogram     latency;        // how late this timer's callbacks ran
+#endif
+  TimerBase(ulong c, ulong p):
+  counter(c),period(p),catchUp(RELATIVE) {
+  };
+  // run pT's callback(s) for a deadline 'late' ms ago, true if the timer stays
+  template<class T> static bool expire(T* pT, ulong late);
+public:
+  ulong getCounter() {
+    return counter;
+  }
+  void setCounter(ulong c) {
+    counter=c;
+  }
+  ulong getPeriod() {
+    return period;
+  }
+  void setPeriod(ulong p) {
+    period=p;
+  }
+#if defined EFL_STATS
+  Histogram& getLatency() {
+    return latency;
+  }
+#endif
+  CatchUp getCatchUp() {
+    return (CatchUp)catchUp;
+  }
+  void setCatchUp(CatchUp c) {
+    catchUp=c;
+  }
+  // counter to reload after a periodic timer fired 'late' ms after its deadline
+  ulong rearm(ulong late) {
+    if (catchUp != RELATIVE)    // the next deadline on the grid
+      return period - late % period;
+    // policy decision here. Do we set the counter to 0 or less if
+    // we're late by the period or more? No, I guess...
+    return (late >= period) ? 1 : period - late;
+  }
+};
+
+template<class T>
+bool TimerBase::expire(T* pT, ulong late)
+{
+  EFL_STAT(pT->latency.record(late));
+  ulong period = pT->period;
+  ulong missed = (period && late >= period) ? late / period : 0;
+  switch (pT->catchUp) {
+    case SKIP:
+      late -= missed * period;
+      missed = 0;
+      break;
+    case BURST:                 // oldest first
+      for (; missed; missed--, late -= period)
+        if (!pT->callbackMissed(late, 0))
+          return false;
+      break;
+    case COALESCE:
+      break;
+    default:
+      missed = 0;
+      break;
+  }
+  return pT->callbackMissed(late, missed) && period > 0; // need both period and 'true' response to keep active
+}
+
+class Timer:
+  public TimerBase
+{
+private:
+#if defined EFL_TIMER_DEADLINE
+  ulong           deadline;     // absolute expiry (list clock) while scheduled
+  TimerScheduler* pSched;       // scheduler holding this timer, 0 if none
+#endif
+#if defined EFL_TIMER_WHEEL
+  friend class TimerWheel;
+  LL<Timer>*    pNextW;         // next node in the same wheel slot
+  LL<Timer>**   ppPrevW;        // link that points to this timer's node
+#elif defined EFL_TIMER_HEAP
+  friend class TimerHeap;
+  uint          heapIndex;      // position in the heap
+#endif
+#if defined EFL_FN_CALLBACKS
+public:
+  typedef bool (*Fn)(Timer* pT, ulong late, ulong missed);
+private:
+  Fn            pFn;            // 0 for the default (one shot, no action)
+#endif
+public:
+#if defined EFL_FN_CALLBACKS
+  Timer(ulong c=1, ulong p=0, Fn fn=0):
+  TimerBase(c, p)
+#else
+  Timer(ulong c=1, ulong p=0):
+  TimerBase(c, p)
+#endif
+#if defined EFL_TIMER_WHEEL
+  ,deadline(0),pSched(0),pNextW(0),ppPrevW(0)
+#elif defined EFL_TIMER_HEAP
+  ,deadline(0),pSched(0),heapIndex(0)
+#endif
+#if defined EFL_FN_CALLBACKS
+  ,pFn(fn)
+#endif
+  {
+  }; // default to fire once after 1 ms
+#if defined EFL_FN_CALLBACKS
+  bool callback(ulong late) {
+    return callbackMissed(late, 0);
+  };
+  bool callbackMissed(ulong late, ulong missed) {
+    if (pFn)
+      return pFn(this, late, missed);
+    if (verbose) {
+      coln( "Timer:");
+    }
+    return false;
+  };
+#else
+  virtual bool callback(ulong late) {
+    if (verbose) {
+      coln( "Timer:");
+    }
+    return false;
+  };
+  virtual bool callbackMissed(ulong late, ulong missed) { /// COALESCE timers get the
+    return callback(late);                              /// deadlines missed as well
+  };
+#endif
+#if defined EFL_TIMER_DEADLINE
+  ulong getCounter();           // what is left of it while scheduled
+  void setCounter(ulong c);     // and reschedules
+#endif
+  bool expire(ulong late) {
+    return TimerBase::expire(this, late);
+  };
+#if !defined EFL_FN_CALLBACKS
+  virtual ~Timer(){}; // virtual destructor to quash warnings
+#endif
+};
+
+#if defined EFL_FN_CALLBACKS
+template<> struct FnOnly<Timer> {
+  // &Derived::callback is a Timer member only if Derived doesn't declare one
+  static char inherited(bool (Timer::*)(ulong));
+  static char inherited(bool (Timer::*)(ulong, ulong));
+  template<class Member> static long inherited(Member);
+  template<class Derived> static void check(Derived*) {   // fails: Derived overrides a callback,
+    (void)sizeof(char[sizeof(inherited(&Derived::callback)) == 1 ? 1 : -1]);   // pass Timer a function
+    (void)sizeof(char[sizeof(inherited(&Derived::callbackMissed)) == 1 ? 1 : -1]);
+  };
+};
+#endif
+
+/*
+ * Derive Tick from StaticTimer<Tick> and give it bool callback(ulong late)
+ * (and callbackMissed(late, missed) for COALESCE) to list it in a
+ * List<Tick>. Such a list always down counts, whatever the Timer backend.
+ */
+template<class Derived> class StaticTimer:
+  public TimerBase
+{
+public:
+  StaticTimer(ulong c=1, ulong p=0):
+  TimerBase(c, p) {
+  };
+  bool callbackMissed(ulong late, ulong) {   // unless Derived has its own
+    return static_cast<Derived*>(this)->callback(late);
+  };
+  bool expire(ulong late) {
+    return TimerBase::expire(static_cast<Derived*>(this), late);
+  };
+};
+
+/*
+ * The down count: every listed timer is counted down by the time since the
+ * previous pass, and those that reach zero expire. The default List<Timer>
+ * runs it unless a scheduler (EFL_TIMER_WHEEL, EFL_TIMER_HEAP) does, and
+ * a List of StaticTimers always runs it.
+ */
+template<class Item>
+bool List<Item>::onePass(ulong nowMillis, TimerBase*)
+{
+  ulong   deltaMillis = nowMillis - prevMillis;
+  bool    ran = false;
+
+  if(!deltaMillis)
+    return false;
+  if(!count)
+  {
+    prevMillis = nowMillis;
+    return false;
+  }
+
+  // iterate through timers to see which ones have down counted to or beyond zero
+  for(LL<Item>* pLL = begin(); pLL != end(); )
+  {
+    ulong late=deltaMillis - pLL->pItem->getCounter();
+    if( pLL->pItem->getCounter() <= deltaMillis )
+    {
+      ran = true;
+      EFL_STAT(stats.latency.record(late));
+      EFL_STAT(ulong began = Stats::clock());
+      bool keep = pLL->pItem->expire(late);
+      EFL_STAT(stats.ran(began));
+      if( keep )
+      {
+        pLL->pItem->setCounter(pLL->pItem->rearm(late));
+        pLL = pLL->next();
+      }
+      else
+      {
+        pLL = pLL->erase(*this);
+      }
+    }
+    else
+    {
+      pLL->pItem->setCounter(pLL->pItem->getCounter()-deltaMillis);
+      pLL = pLL->next();
+    }
+  }
+  prevMillis = nowMillis;
+  return ran;
+}
+
+template<class Item>
+ulong List<Item>::idleFor(ulong nowMillis, ulong limit, TimerBase*)
+{
+  for(LL<Item>* pLL = begin(); pLL != end(); pLL = pLL->next())
+  {
+    long wait = prevMillis + pLL->pItem->getCounter() - nowMillis;
+    if( wait <= 0 )
+      return 0;
+    if( (ulong)wait < limit )
+      limit = wait;
+  }
+  return limit;
+}
+
+#if defined EFL_TIMER_WHEEL
+
+#if !defined EFL_WHEEL_BITS     // log2 of the slots per wheel level
+#if defined AVR
+#define EFL_WHEEL_BITS 3
+#else
+#define EFL_WHEEL_BITS 6
+#endif
+#endif
+#if !defined EFL_WHEEL_LEVELS   // number of wheel levels
+#define EFL_WHEEL_LEVELS 4
+#endif
+#if EFL_WHEEL_BITS * EFL_WHEEL_LEVELS >= 32
+#error "EFL_WHEEL_BITS * EFL_WHEEL_LEVELS must leave room in a 32 bit ulong"
+#endif
+
+/*
+ * Hierarchical timing wheel (after the classic Linux kernel timer wheel.)
+ * Level 0 has one slot per millisecond, each higher level has slots
+ * SLOTS times wider. A timer sits in the level that matches how far away
+ * its deadline is and is cascaded down a level each time the level below
+ * wraps. Deadlines beyond the span of the wheel park in the top level and
+ * are re-evaluated each time they cascade, so any period works. A pass costs
+ * one slot per elapsed millisecond plus the timers that actually expire.
+ *
+ * Slots hold LL<Timer> nodes so that expired one shots can be erased from
+ * LL<Timer> without scanning for them. The links live in the Timer.
+ */
+class TimerWheel {
+public:
+  enum {
+    BITS = EFL_WHEEL_BITS,
+    SLOTS = 1 << BITS,
+    MASK = SLOTS - 1,
+    LEVELS = EFL_WHEEL_LEVELS
+  };
+
+  TimerWheel(): pClock(millis), tick(0), count(0) {
+    for (uchar l = 0; l < LEVELS; l++)
+      for (uchar i = 0; i < SLOTS; i++)
+        slot[l][i] = 0;
+  };
+  Clock pClock;                             // the clock of the list it serves
+  ulong now() {
+    return pClock();
+  };
+  static TimerWheel& instance();            // the wheel of the default list
+  bool insert(LL<Timer>* pLL, ulong now);   // schedule counter ms after now
+  void remove(LL<Timer>* pLL);              // unschedule (no-op if not here)
+  bool doItems(List<Timer>& list, ulong now); // run everything due by now, true if any ran
+  bool nextDeadline(ulong& when);           // false if no timer is pending
+  int size() {
+    return count;
+  };
+  static LL<Timer>* node(Timer* pT) {       // the link to a timer holds its node
+    return *pT->ppPrevW;
+  };
+
+private:
+  void link(LL<Timer>* pLL);                // place in slot per deadline
+  void unlink(LL<Timer>* pLL);
+  void cascade(uchar level, uchar index);   // move a slot down a level
+  static ulong span() {
+    return (ulong)1 << (BITS * LEVELS);
+  };
+
+  LL<Timer>*  slot[LEVELS][SLOTS];
+  ulong       tick;                         // next tick to be processed
+  int         count;                        // timers in the wheel
+};
+
+#elif defined EFL_TIMER_HEAP
+
+#if !defined EFL_HEAP_SIZE      // most timers the heap can hold
+#if defined AVR
+#define EFL_HEAP_SIZE 16
+#else
+#define EFL_HEAP_SIZE 1024
+#endif
+#endif
+
+/*
+ * Binary min-heap of LL<Timer> nodes ordered by absolute deadline. Adding,
+ * removing or firing a timer costs O(log n) and a pass that finds nothing
+ * due costs one comparison, so an idle caller can ask nextDeadline() how
+ * long it may sleep. Deadlines are compared as signed differences so that
+ * millis() wrapping around is harmless. The heap has a fixed capacity;
+ * LL<Timer>::add() reports NAK when it is full.
+ */
+class TimerHeap {
+public:
+  TimerHeap(): pClock(millis), count(0) {
+  };
+  Clock pClock;                             // the clock of the list it serves
+  ulong now() {
+    return pClock();
+  };
+  static TimerHeap& instance();             // the heap of the default list
+  bool insert(LL<Timer>* pLL, ulong now);   // schedule counter ms after now
+  void remove(LL<Timer>* pLL);              // unschedule (no-op if not here)
+  bool doItems(List<Timer>& list, ulong now); // run everything due by now, true if any ran
+  bool nextDeadline(ulong& when) {          // false if no timer is pending
+    if (!count)
+      return false;
+    when = heap[0]->item()->deadline;
+    return true;
+  };
+  int size() {
+    return count;
+  };
+  LL<Timer>* node(Timer* pT) {
+    return heap[pT->heapIndex];
+  };
+
+private:
+  static bool before(LL<Timer>* a, LL<Timer>* b) {
+    return (long)(a->item()->deadline - b->item()->deadline) < 0;
+  };
+  void place(uint i, LL<Timer>* pLL) {
+    heap[i] = pLL;
+    pLL->item()->heapIndex = i;
+  };
+  void siftUp(uint i);
+  void siftDown(uint i);
+
+  LL<Timer>*  heap[EFL_HEAP_SIZE];
+  uint        count;
+};
+
+#endif // defined EFL_TIMER_WHEEL, EFL_TIMER_HEAP
+
+#if defined EFL_TIMER_DEADLINE
+
+template<> struct Hooks<Timer> {
+  TimerScheduler sched;                     // the timers of this list
+  bool added(LL<Timer>* pLL, bool) {
+    return sched.insert(pLL, sched.now());
+  };
+  void erased(LL<Timer>* pLL) {
+    sched.remove(pLL);
+  };
+  void setClock(Clock clock) {
+    sched.pClock = clock;
+  };
+};
+
+#endif // defined EFL_TIMER_DEADLINE
+
+#if defined EFL_TIMER_WHEEL
+
+void TimerWheel::link(LL<Timer>* pLL)
+{
+  Timer*  pT = pLL->item();
+  ulong   expires = pT->deadline;
+  ulong   idx = expires - tick;
+  uchar   level = 0;
+
+  if ((long)idx < 0) {                      // overdue, run on the next tick
+    expires = tick;
+    idx = 0;
+  }
+  else if (idx >= span()) {                 // beyond the wheel, park it in the
+    expires = tick + span() - 1;            // top level and look again when
+    idx = span() - 1;                       // it cascades
+  }
+  while (level < LEVELS - 1 && (idx >> (BITS * (level + 1))))
+    level++;
+
+  LL<Timer>** ppHead = &slot[level][(expires >> (BITS * level)) & MASK];
+  pT->pNextW = *ppHead;
+  if (*ppHead)
+    (*ppHead)->item()->ppPrevW = &pT->pNextW;
+  *ppHead = pLL;
+  pT->ppPrevW = ppHead;
+}
+
+void TimerWheel::unlink(LL<Timer>* pLL)
+{
+  Timer*  pT = pLL->item();
+  *pT->ppPrevW = pT->pNextW;
+  if (pT->pNextW)
+    pT->pNextW->item()->ppPrevW = pT->ppPrevW;
+  pT->pNextW = 0;
+  pT->ppPrevW = 0;
+}
+
+bool TimerWheel::insert(LL<Timer>* pLL, ulong now)
+{
+  Timer*  pT = pLL->item();
+  if (pT->pSched)
+    pT->pSched->remove(pLL);
+  if (!count)                               // nothing pending, catch up for free
+    tick = now;
+  pT->deadline = now + pT->counter;
+  pT->pSched = this;
+  count++;
+  link(pLL);
+  return true;
+}
+
+void TimerWheel::remove(LL<Timer>* pLL)
+{
+  Timer*  pT = pLL->item();
+  if (pT->pSched != this)
+    return;
+  unlink(pLL);
+  pT->pSched = 0;
+  count--;
+}
+
+void TimerWheel::cascade(uchar level, uchar index)
+{
+  LL<Timer>* pending = slot[level][index];
+  slot[level][index] = 0;
+  if (pending)
+    pending->item()->ppPrevW = &pending;
+  while (pending) {
+    LL<Timer>* pLL = pending;
+    unlink(pLL);
+    link(pLL);
+  }
+}
+
+bool TimerWheel::doItems(List<Timer>& list, ulong now)
+{
+  bool ran = false;
+  while ((long)(now - tick) >= 0) {
+    if (!count) {                           // idle, skip the empty slots
+      tick = now + 1;
+      break;
+    }
+    uchar index = tick & MASK;
+    for (uchar l = 1; !index && l < LEVELS; l++) {
+      index = (tick >> (BITS * l)) & MASK;
+      cascade(l, index);
+    }
+    index = tick & MASK;
+    tick++;
+
+    // detach the slot so callbacks can add and erase timers freely
+    LL<Timer>* pending = slot[0][index];
+    slot[0][index] = 0;
+    if (pending)
+      pending->item()->ppPrevW = &pending;
+    while (pending) {
+      LL<Timer>*  pLL = pending;
+      Timer*      pT = pLL->item();
+      unlink(pLL);
+      pT->pSched = 0;
+      count--;
+      ran = true;
+
+      ulong late = now - pT->deadline;
+      EFL_STAT(list.stats.latency.record(late));
+      EFL_STAT(ulong began = Stats::clock());
+      bool keep = pT->expire(late);
+      EFL_STAT(list.stats.ran(began));
+      if (keep) {
+        if (pLL->next() != pLL && !pT->pSched) {      // unless the callback erased or rescheduled it
+          pT->deadline = now + pT->rearm(late);
+          pT->pSched = this;
+          count++;
+          link(pLL);
+        }
+      }
+      else {
+        pLL->erase(list);
+      }
+    }
+  }
+  return ran;
+}
+
+/*
+ * The wheel next has work at the first tick whose level 0 slot holds a
+ * timer or which cascades a non empty slot of a higher level. A timer may
+ * be due later than the cascade that moves it, so this can be early but
+ * never late.
+ */
+bool TimerWheel::nextDeadline(ulong& when)
+{
+  if (!count)
+    return false;
+  bool found = false;
+  for (uchar l = 0; l < LEVELS; l++) {
+    uchar shift = BITS * l;
+    ulong base = tick >> shift;             // in units of this level's slots
+    if (tick & (((ulong)1 << shift) - 1))
+      base++;                               // this one has already cascaded
+    for (uint i = 0; i < SLOTS; i++) {
+      ulong at = (base + i) << shift;       // when that slot is reached
+      if (found && (long)(at - when) >= 0)
+        break;
+      if (slot[l][(base + i) & MASK]) {
+        when = at;
+        found = true;
+        break;
+      }
+    }
+  }
+  if (!found)                               // can't happen, look again later
+    when = tick + SLOTS;
+  return true;
+}
+
+#elif defined EFL_TIMER_HEAP
+
+void TimerHeap::siftUp(uint i)
+{
+  LL<Timer>* pLL = heap[i];
+  while (i > 0 && before(pLL, heap[(i - 1) / 2])) {
+    place(i, heap[(i - 1) / 2]);
+    i = (i - 1) / 2;
+  }
+  place(i, pLL);
+}
+
+void TimerHeap::siftDown(uint i)
+{
+  LL<Timer>* pLL = heap[i];
+  for (;;) {
+    uint child = 2 * i + 1;
+    if (child >= count)
+      break;
+    if (child + 1 < count && before(heap[child + 1], heap[child]))
+      child++;
+    if (!before(heap[child], pLL))
+      break;
+    place(i, heap[child]);
+    i = child;
+  }
+  place(i, pLL);
+}
+
+bool TimerHeap::insert(LL<Timer>* pLL, ulong now)
+{
+  Timer*  pT = pLL->item();
+  if (pT->pSched)
+    pT->pSched->remove(pLL);
+  if (count >= EFL_HEAP_SIZE)
+    return false;
+  pT->deadline = now + pT->counter;
+  pT->pSched = this;
+  place(count, pLL);
+  siftUp(count++);
+  return true;
+}
+
+void TimerHeap::remove(LL<Timer>* pLL)
+{
+  Timer*  pT = pLL->item();
+  if (pT->pSched != this)
+    return;
+  uint i = pT->heapIndex;
+  pT->pSched = 0;
+  if (i == --count)
+    return;
+  LL<Timer>* pLast = heap[count];           // fill the hole with the last one
+  place(i, pLast);
+  siftUp(i);
+  siftDown(pLast->item()->heapIndex);
+}
 
-  // iterate through timers to see which ones have down counted to or beyond zero
-  for(LL<Timer>* pLL = begin(); pLL != end(); )
+bool TimerHeap::doItems(List<Timer>& list, ulong now)
+{
+  bool ran = false;
+  while (count && (long)(now - heap[0]->item()->deadline) >= 0) {
+    LL<Timer>*  pLL = heap[0];
+    Timer*      pT = pLL->item();
+    remove(pLL);
+    ran = true;
+
+    ulong late = now - pT->deadline;
+    EFL_STAT(list.stats.latency.record(late));
+    EFL_STAT(ulong began = Stats::clock());
+    bool keep = pT->expire(late);
+    EFL_STAT(list.stats.ran(began));
+    if (keep) {
+      if (pLL->next() != pLL && !pT->pSched) {        // unless the callback erased or rescheduled it
+        pT->counter = pT->rearm(late);
+        if (!insert(pLL, now))
+          pLL->erase(list);
+      }
+    }
+    else {
+      pLL->erase(list);
+    }
+  }
+  return ran;
+}
+
+#endif // defined EFL_TIMER_WHEEL, EFL_TIMER_HEAP
+
+#if defined EFL_TIMER_DEADLINE
+
+ulong Timer::getCounter()
+{
+  if (pSched) {                 // report what is left until the deadline
+    long left = deadline - pSched->now();
+    return left > 0 ? left : 0;
+  }
+  return counter;
+}
+
+void Timer::setCounter(ulong c)
+{
+  counter=c;
+  if (pSched)                   // restart the count from now
+    pSched->insert(pSched->node(this), pSched->now());
+}
+
+TimerScheduler& TimerScheduler::instance()
+{
+  return List<Timer>::instance().hooks.sched;
+}
+
+template<>
+bool List<Timer>::onePass(ulong now)
+{
+  return hooks.sched.doItems(*this, now);
+}
+
+template<>
+ulong List<Timer>::idleFor(ulong now, ulong limit)
+{
+  ulong when;
+  if (!hooks.sched.nextDeadline(when))
+    return limit;
+  long wait = when - now;
+  return wait <= 0 ? 0 : ((ulong)wait < limit ? wait : limit);
+}
+
+#endif // defined EFL_TIMER_DEADLINE
+
+#define DIGITAL
+#if defined DIGITAL
+
+/**
+ * Provide a framework to respond to changes in state of digital inputs including 
+ * debouncing the input for a specified time (in milliseconds.)
+ *
+ * DigitalBase holds an input's settings and its state machine. update()
+ * and setState() call back through the type they are given, so the call
+ * is bound at compile time when that type is known. Digital adds the
+ * callback, virtual or (EFL_FN_CALLBACKS) a stored function, and is what
+ * the input engines below run. StaticDigital<Derived> adds nothing: a
+ * List<Derived> of them is polled and calls Derived::callback() directly.
+ */
+
+class DigitalBase
+{
+public:
+  typedef enum      /// interpreted state of the input
   {
-    ulong late=deltaMillis - pLL->pItem->getCounter();
-    if( pLL->pItem->getCounter() <= deltaMillis )
-    {
-      if( pLL->pItem->callback(late) && pLL->pItem->getPeriod() > 0 ) // need both period and 'true' response to keep active
-      {
-        // policy decision here. Do we set the counter to 0 or less if
-        // we're late by the period or more? No, I guess...
-        if( late >= pLL->pItem->getPeriod())
-          pLL->pItem->setCounter(1);
+    INACTIVE =      (1<<0),	//1
+    GOING_ACTIVE =  (1<<1),	//2
+    ACTIVE =        (1<<2),	//4
+    GOING_INACTIVE =(1<<3),	//8
+  } States;
+
+  typedef enum/// input polarity
+  {
+    ACT_LO,
+    ACT_HI,
+  } Polarity;
+
+  typedef enum      /// valid digital input bits for an Arduino Uno
+  {                 // an enumerated value is chosen to
+      BIT_1 = 1,    // provide some guarantee that a valid
+      BIT_2,        // bit is specified.
+      BIT_3,
+      BIT_4,
+      BIT_5,
+      BIT_6,
+      BIT_7,
+      BIT_8,
+      BIT_9,
+      BIT_10,
+      BIT_11,
+      BIT_12,
+      BIT_13,
+      AN_0,    // pseudo digital inputs, I suppose.
+      AN_1,
+      AN_2,
+      AN_3,
+      AN_4,
+      AN_5,
+  } DigitalBit;
+ 
+
+protected:
+  int           id;
+  uint          debounce;
+  int           debounceCounter;
+  States        state;
+  Polarity      polarity;
+  DigitalBit    pin;
+  uchar         interestMask;
+
+  DigitalBase( int id, DigitalBit b, int d, Polarity p, uchar interest):
+  id(id), debounce(d), debounceCounter(0), state(INACTIVE), polarity(p), pin(b), interestMask(interest)
+  {
+     pinMode(pin, INPUT);      // should this be done in setup?
+  };
+
+    /*
+     * I hate to pass in the flag to indicate that this is a 'significant' change worthy of a callback
+     * but the logic is so much easier where the states are managed.
+     */
+  template<class T> static void setState(T* pT, States s) {
+      States oldState = pT->state;
+      pT->state=s;
+      if( pT->interestMask & s)
+          pT->callback(0, s, oldState);
+  };
+  template<class T> static void update(T* pT, bool sense, uint delta);  // run the state machine
+
+public:
+  States getState() { return state;};
+  bool getSense() { return (polarity==ACT_HI)?digitalRead(pin):!digitalRead(pin); };
+  int getID() { return id; };
+  DigitalBit getPin() { return pin; };
+  Polarity getPolarity() { return polarity; };
+  uint setDebounceCounter() { return debounceCounter = debounce; };
+  uint getDebounce() { return debounce; };
+  int decrementDebounce(uint delta) { return debounceCounter -= delta; };
+  int getDebounceCounter() { return debounceCounter; };
+};
+
+/*
+ * Run the state machine for one input given its sense (true when active)
+ * and the time since the previous pass.
+ */
+template<class T>
+void DigitalBase::update(T* pT, bool sense, uint delta)
+{
+  switch(pT->state) {
+    case INACTIVE:
+      if( sense ) {
+        EFL_TRACE(EFL_TRACE_DEBUG, EFL_TRACE_DIGITAL, pT->id, TRACE_GOING_ACTIVE);
+        if( pT->debounce > 0 ) {
+          setState(pT, GOING_ACTIVE);
+          pT->setDebounceCounter();
+        }
+        else {
+          setState(pT, ACTIVE);
+        }
+      }
+      break;
+
+    case GOING_INACTIVE:
+    case GOING_ACTIVE:
+      if( pT->decrementDebounce(delta) <= 0) {
+        EFL_TRACE(EFL_TRACE_DEBUG, EFL_TRACE_DIGITAL, pT->id, TRACE_DEBOUNCED);
+        if( sense )
+          setState(pT, ACTIVE);
         else
-          pLL->pItem->setCounter(pLL->pItem->getPeriod()-late);
-        pLL = pLL->next();
+          setState(pT, INACTIVE);
       }
-      else
-      {
-        pLL = pLL->erase();
+      break;
+
+    case ACTIVE:
+      if( !sense ) {
+        EFL_TRACE(EFL_TRACE_DEBUG, EFL_TRACE_DIGITAL, pT->id, TRACE_GOING_INACTIVE);
+        if( pT->debounce > 0 ) {
+          setState(pT, GOING_INACTIVE);
+          pT->setDebounceCounter();
+        }
+        else {
+          setState(pT, INACTIVE);
+        }
       }
-    }
-    else
-    {
-      pLL->pItem->setCounter(pLL->pItem->getCounter()-deltaMillis);
-      pLL = pLL->next();
-    }
+      break;
+
+    default:
+      EFL_TRACE(EFL_TRACE_ERROR, EFL_TRACE_DIGITAL, pT->id, TRACE_BAD_STATE);
+      setState(pT, INACTIVE); // what else to do here?
+      break;
   }
+}
+
+class Digital:
+  public DigitalBase
+{
+#if defined EFL_FN_CALLBACKS
+public:
+  typedef bool (*Fn)(Digital* pD, ulong late, States newState, States oldState);
+private:
+  Fn            pFn;            // 0 for the default (no action)
+#endif
+
+public:
+#if defined EFL_FN_CALLBACKS
+  Digital( int id, DigitalBit b,int d = 1, Polarity p = ACT_HI, uchar interest = (INACTIVE|ACTIVE), Fn fn = 0):
+  DigitalBase(id, b, d, p, interest), pFn(fn)
+#else
+  Digital( int id, DigitalBit b,int d = 1, Polarity p = ACT_HI, uchar interest = (INACTIVE|ACTIVE)):
+  DigitalBase(id, b, d, p, interest)
+#endif
+  {
+  };				// defaults: 1 ms debounce and active high polarity
+                    // and interest in transitions to inactive or active only
+
+  void setState(States s) {
+      DigitalBase::setState(this, s);
+  };
+  void update(bool sense, uint delta) {
+      DigitalBase::update(this, sense, delta);
+  };
+#if defined EFL_FN_CALLBACKS
+  bool callback (ulong late, States newState, States oldState) {   /// callback on state changes
+    if (pFn)
+      return pFn(this, late, newState, oldState);
+    if (verbose)
+	  coln (X("Digital:"));
+    return false;
+  };
+#else
+  virtual bool callback (ulong late, States newState, States oldState) {   /// callback on state changes
+
+    if (verbose)
+	  coln (X("Digital:"));
+    return false;
+  };
+  virtual ~Digital() {}; // nothing to destroy
+#endif
+};
+
+#if defined EFL_FN_CALLBACKS
+template<> struct FnOnly<Digital> {
+  // &Derived::callback is a Digital member only if Derived doesn't declare one
+  static char inherited(bool (Digital::*)(ulong, Digital::States, Digital::States));
+  template<class Member> static long inherited(Member);
+  template<class Derived> static void check(Derived*) {   // fails: Derived overrides callback(),
+    (void)sizeof(char[sizeof(inherited(&Derived::callback)) == 1 ? 1 : -1]);   // pass Digital a function
+  };
+};
+#endif
+
+/*
+ * Derive Button from StaticDigital<Button> and give it
+ * bool callback(ulong late, States newState, States oldState) to list it
+ * in a List<Button>. Such a list polls every pin each pass, whatever the
+ * Digital engine.
+ */
+template<class Derived> class StaticDigital:
+  public DigitalBase
+{
+public:
+  StaticDigital( int id, DigitalBit b,int d = 1, Polarity p = ACT_HI, uchar interest = (INACTIVE|ACTIVE)):
+  DigitalBase(id, b, d, p, interest) {
+  };
+  void update(bool sense, uint delta) {
+      DigitalBase::update(static_cast<Derived*>(this), sense, delta);
+  };
+};
+
+/*
+ * The poll: every listed input is read and run through its state machine
+ * each pass. The default List<Digital> runs it unless another engine
+ * (EFL_DIGITAL_EDGE, _PORTS, _VERTICAL) is chosen, and a List of
+ * StaticDigitals always runs it. It needs a pass every millisecond.
+ */
+template<class Item>
+bool List<Item>::onePass(ulong nowMillis, DigitalBase*)
+{
+  uint   deltaMillis = nowMillis - prevMillis;
+  bool   changed = false;        // any input changed state
+
+  if(!deltaMillis)
+    return false;
   prevMillis = nowMillis;
+  for(LL<Item>* pLL = begin(); pLL != end(); pLL = pLL->next()) {
+    DigitalBase::States was = pLL->pItem->getState();
+    pLL->pItem->update(pLL->pItem->getSense(), deltaMillis);
+    changed |= pLL->pItem->getState() != was;
+  }
+  return changed;
+}
+
+template<class Item>
+ulong List<Item>::idleFor(ulong nowMillis, ulong limit, DigitalBase*)
+{
+  if(!count)
+    return limit;
+  long wait = prevMillis + 1 - nowMillis;
+  return wait <= 0 ? 0 : (1 < limit ? 1 : limit);
+}
+#if defined EFL_DIGITAL_VERTICAL && !defined EFL_DIGITAL_PORTS
+#define EFL_DIGITAL_PORTS     // the vertical engine works on sampled ports
+#endif
+#if defined EFL_DIGITAL_VERTICAL && !defined EFL_DEBOUNCE_BITS
+#define EFL_DEBOUNCE_BITS 8   // longest debounce is 2^bits - 1 ms
+#endif
+#if defined EFL_DIGITAL_EDGE && defined EFL_DIGITAL_PORTS
+#error "define at most one of EFL_DIGITAL_EDGE and EFL_DIGITAL_PORTS"
+#endif
+#if defined EFL_DIGITAL_EDGE || defined EFL_DIGITAL_PORTS
+
+/*
+ * By default a pass reads every input with digitalRead(). Two modes visit
+ * only the pins that need it, in pin order:
+ *  EFL_DIGITAL_EDGE    an edge on a pin is reported with pinChanged(), by
+ *                      the pin change interrupts on AVR (which feed the
+ *                      default list) or by the IO stub elsewhere. Pins with
+ *                      an edge or a debounce in progress are visited.
+ *  EFL_DIGITAL_PORTS   a pass samples all the pins at once with readPins()
+ *                      (PIND, PINB and PINC on AVR, the IO stub's
+ *                      digitalReadPins() elsewhere) and applies polarity
+ *                      with one XOR. Pins whose sense differs from their
+ *                      settled state or that are debouncing are visited.
+ *  EFL_DIGITAL_VERTICAL  port sampling plus a bit parallel debounce: the
+ *                      debounce counters of all pins are held as bitplanes
+ *                      (plane n holds bit n of every pin's counter) and one
+ *                      pass counts all of them down with a borrow chain of
+ *                      EFL_DEBOUNCE_BITS steps. Only pins that change state
+ *                      are visited, to report it through setState(), so
+ *                      callbacks and the interestMask work as before.
+ *                      Debounce times are clamped to 2^EFL_DEBOUNCE_BITS-1.
+ * Either way a list watches each pin with at most one Digital; add()
+ * reports NAK for a second one.
+ */
+template<> struct Hooks<Digital> {
+  enum {
+    PINS = Digital::AN_5 + 1
+  };
+  LL<Digital>*    byPin[PINS];      // the node watching each pin
+  ulong           debouncing;       // pins in a debounce window
+#if defined EFL_DIGITAL_EDGE
+  volatile ulong  edges;            // pins with an edge since the last pass
+#else
+  ulong           watched;          // pins with a node
+  ulong           activeLow;        // pins whose sense is the inverted level
+  ulong           active;           // pins settled ACTIVE
+#endif
+#if defined EFL_DIGITAL_VERTICAL
+  ulong           debounced;        // pins with a non zero debounce
+  ulong           preset[EFL_DEBOUNCE_BITS];  // each pin's debounce, as bitplanes
+  ulong           plane[EFL_DEBOUNCE_BITS];   // the running counters
+#endif
+  Hooks(): debouncing(0),
+#if defined EFL_DIGITAL_EDGE
+  edges(0) {
+#else
+  watched(0), activeLow(0), active(0) {
+#endif
+    for (uint i = 0; i < PINS; i++)
+      byPin[i] = 0;
+#if defined EFL_DIGITAL_VERTICAL
+    debounced = 0;
+    for (uint i = 0; i < EFL_DEBOUNCE_BITS; i++)
+      preset[i] = plane[i] = 0;
+#endif
+  };
+  bool added(LL<Digital>* pLL, bool front);
+  void erased(LL<Digital>* pLL);
+  void setClock(Clock) {};
+  void visited(uchar pin, Digital::States state) {
+    ulong b = 1UL << pin;
+    if (state & (Digital::GOING_ACTIVE|Digital::GOING_INACTIVE))
+      debouncing |= b;
+    else
+      debouncing &= ~b;
+#if defined EFL_DIGITAL_PORTS
+    if (state & (Digital::ACTIVE|Digital::GOING_INACTIVE))
+      active |= b;
+    else
+      active &= ~b;
+#endif
+  };
+#if defined EFL_DIGITAL_VERTICAL
+  void load(ulong pins) {           // restart the counters of pins
+    for (uint i = 0; i < EFL_DEBOUNCE_BITS; i++)
+      plane[i] = (plane[i] & ~pins) | (preset[i] & pins);
+  };
+  uint left(uchar pin) {            // a pin's running counter
+    uint rc = 0;
+    for (uint i = 0; i < EFL_DEBOUNCE_BITS; i++)
+      rc |= ((plane[i] >> pin) & 1) << i;
+    return rc;
+  };
+  ulong countDown(uint delta) {     // the debouncing pins that reach zero
+    ulong borrow = 0;
+    ulong left = 0;                 // pins with a counter still above zero
+    for (uint i = 0; i < EFL_DEBOUNCE_BITS; i++) {
+      ulong a = plane[i];
+      ulong d = ((delta >> i) & 1) ? ~0UL : 0;
+      ulong diff = a ^ d ^ borrow;
+      borrow = (~a & (d | borrow)) | (d & borrow);
+      plane[i] = (a & ~debouncing) | (diff & debouncing);
+      left |= diff;
+    }
+    if (delta >> EFL_DEBOUNCE_BITS)
+      borrow = ~0UL;
+    return debouncing & (borrow | ~left);
+  };
+#endif
+#if defined EFL_DIGITAL_EDGE
+  void edge(uchar pin) {            // ISR safe
+    if (pin >= PINS)
+      return;
+#if defined AVR
+    uchar sreg = SREG;
+    cli();
+    edges |= 1UL << pin;
+    SREG = sreg;
+#else
+    __atomic_fetch_or(&edges, 1UL << pin, __ATOMIC_RELEASE);
+#endif
+  };
+  ulong take() {                    // the reported edges, cleared
+#if defined AVR
+    uchar sreg = SREG;
+    cli();
+    ulong rc = edges;
+    edges = 0;
+    SREG = sreg;
+    return rc;
+#else
+    return __atomic_exchange_n(&edges, 0UL, __ATOMIC_ACQUIRE);
+#endif
+  };
+#endif
+};
+
+bool Hooks<Digital>::added(LL<Digital>* pLL, bool)
+{
+  uchar pin = pLL->item()->getPin();
+  if (pin >= PINS || byPin[pin])
+    return false;
+  byPin[pin] = pLL;
+  visited(pin, pLL->item()->getState());
+#if defined EFL_DIGITAL_EDGE
+#if defined AVR
+  *digitalPinToPCMSK(pin) |= bit(digitalPinToPCMSKbit(pin));
+  PCICR |= bit(digitalPinToPCICRbit(pin));
+#endif
+  edge(pin);                        // so the first pass looks at it
+#else
+  watched |= 1UL << pin;
+  if (pLL->item()->getPolarity() == Digital::ACT_LO)
+    activeLow |= 1UL << pin;
+  else
+    activeLow &= ~(1UL << pin);
+#endif
+#if defined EFL_DIGITAL_VERTICAL
+  uint d = pLL->item()->getDebounce();
+  if (d >> EFL_DEBOUNCE_BITS)
+    d = (1U << EFL_DEBOUNCE_BITS) - 1;
+  for (uint i = 0; i < EFL_DEBOUNCE_BITS; i++)
+    if ((d >> i) & 1)
+      preset[i] |= 1UL << pin;
+    else
+      preset[i] &= ~(1UL << pin);
+  if (d)
+    debounced |= 1UL << pin;
+  else
+    debounced &= ~(1UL << pin);
+  load(1UL << pin);
+#endif
+  return true;
+}
+
+void Hooks<Digital>::erased(LL<Digital>* pLL)
+{
+  uchar pin = pLL->item()->getPin();
+  byPin[pin] = 0;                   // an edge interrupt stays enabled, an
+  debouncing &= ~(1UL << pin);      // edge on an unwatched pin is skipped
+#if defined EFL_DIGITAL_PORTS
+  watched &= ~(1UL << pin);
+#endif
+}
+
+#if defined EFL_DIGITAL_EDGE
+// report an edge on pin to list, from an ISR or the IO stub
+inline void pinChanged(uchar pin, List<Digital>& list = List<Digital>::instance())
+{
+  list.hooks.edge(pin);
+#if !defined AVR
+  Wakeup::instance().raise();
+#endif
+}
+#else
+// the level of every pin, bit n for pin n
+inline ulong readPins()
+{
+#if defined AVR
+  return (ulong)PIND | (ulong)(PINB & 0x3F) << 8 | (ulong)(PINC & 0x3F) << 14;
+#else
+  return ::digitalReadPins();
+#endif
+}
+#endif
+
+#endif // defined EFL_DIGITAL_EDGE || defined EFL_DIGITAL_PORTS
+
+#if defined EFL_DIGITAL_EDGE || defined EFL_DIGITAL_PORTS   // else the poll above
+template<>
+bool List<Digital>::onePass(ulong nowMillis) {
+     uint   deltaMillis = nowMillis - prevMillis;
+     bool   changed = false;        // any input changed state
+ 
+     if(!deltaMillis)
+       return false;
+     if(!count) {
+       prevMillis = nowMillis;
+       return false;
+     }
+ 
+//     if(verbose) walk();
+     
+#if defined EFL_DIGITAL_VERTICAL
+ // debounce every pin at once, then visit those that change state
+     ulong sense = readPins() ^ hooks.activeLow;
+     ulong moved = (sense ^ hooks.active) & hooks.watched & ~hooks.debouncing;
+     ulong expired = hooks.countDown(deltaMillis);
+     hooks.load(moved & hooks.debounced);
+     hooks.debouncing = (hooks.debouncing & ~expired) | (moved & hooks.debounced);
+     ulong settled = expired | (moved & ~hooks.debounced);
+     hooks.active = (hooks.active & ~settled) | (sense & settled);
+     ulong pins = moved | expired;
+     changed = pins != 0;
+     for(uchar pin = 0; pins; pin++, pins >>= 1) {
+         LL<Digital>* pLL = (pins & 1) ? hooks.byPin[pin] : 0;
+         if( !pLL )
+             continue;
+         bool on = (sense >> pin) & 1;
+         if( (expired >> pin) & 1 ) {
+             EFL_TRACE(EFL_TRACE_DEBUG, EFL_TRACE_DIGITAL, pLL->pItem->getID(), TRACE_DEBOUNCED);
+             pLL->pItem->setState(on ? Digital::ACTIVE : Digital::INACTIVE);
+         }
+         else {
+             EFL_TRACE(EFL_TRACE_DEBUG, EFL_TRACE_DIGITAL, pLL->pItem->getID(), on ? TRACE_GOING_ACTIVE : TRACE_GOING_INACTIVE);
+             if( (hooks.debounced >> pin) & 1 )
+                 pLL->pItem->setState(on ? Digital::GOING_ACTIVE : Digital::GOING_INACTIVE);
+             else
+                 pLL->pItem->setState(on ? Digital::ACTIVE : Digital::INACTIVE);
+         }
+     }
+#else
+#if defined EFL_DIGITAL_EDGE
+ // visit the pins with an edge or a debounce in progress
+     ulong pins = hooks.take() | hooks.debouncing;
+#else
+ // sample every pin, visit those that moved from their state or are debouncing
+     ulong sense = readPins() ^ hooks.activeLow;
+     ulong pins = ((sense ^ hooks.active) & hooks.watched) | hooks.debouncing;
+#endif
+     for(uchar pin = 0; pins; pin++, pins >>= 1) {
+         LL<Digital>* pLL = (pins & 1) ? hooks.byPin[pin] : 0;
+         if( !pLL )
+             continue;
+         Digital::States was = pLL->pItem->getState();
+#if defined EFL_DIGITAL_EDGE
+         pLL->pItem->update(pLL->pItem->getSense(), deltaMillis);
+#else
+         pLL->pItem->update((sense >> pin) & 1, deltaMillis);
+#endif
+         changed |= pLL->pItem->getState() != was;
+         hooks.visited(pin, pLL->pItem->getState());
+     }
+#endif
+    prevMillis = nowMillis;
+    return changed;
+}
+#endif // defined EFL_DIGITAL_EDGE || defined EFL_DIGITAL_PORTS
+
+/*
+ * Polled inputs need a pass every millisecond (the generic idleFor()).
+ * Edge driven ones only while they debounce or have an edge waiting;
+ * otherwise the pin change wakes the processor.
+ */
+#if defined EFL_DIGITAL_EDGE
+template<>
+ulong List<Digital>::idleFor(ulong nowMillis, ulong limit) {
+     if(!count)
+       return limit;
+     if(hooks.edges)
+       return 0;
+     ulong pins = hooks.debouncing;
+     for(uchar pin = 0; pins; pin++, pins >>= 1) {
+         LL<Digital>* pLL = (pins & 1) ? hooks.byPin[pin] : 0;
+         if( !pLL )
+             continue;
+         long wait = prevMillis + pLL->pItem->getDebounceCounter() - nowMillis;
+         if( wait <= 0 )
+             return 0;
+         if( (ulong)wait < limit )
+             limit = wait;
+     }
+     return limit;
+}
+#endif
+
+/*
+ * A simulation knows when its inputs change, so between changes it only
+ * needs the passes that end debounces; everywhere else polled inputs are
+ * read every millisecond (idleFor() above.)
+ */
+template<>
+ulong List<Digital>::settleFor(ulong nowMillis, ulong limit) {
+#if defined EFL_DIGITAL_EDGE
+     return idleFor(nowMillis, limit);
+#else
+#if defined EFL_DIGITAL_VERTICAL
+     ulong pins = hooks.debouncing;
+     for(uchar pin = 0; pins; pin++, pins >>= 1) {
+         if( !(pins & 1) )
+             continue;
+         long wait = prevMillis + hooks.left(pin) - nowMillis;
+#else
+     for(LL<Digital>* pLL = begin(); pLL != end(); pLL = pLL->next()) {
+         if( !(pLL->pItem->getState() & (Digital::GOING_ACTIVE|Digital::GOING_INACTIVE)) )
+             continue;
+         long wait = prevMillis + pLL->pItem->getDebounceCounter() - nowMillis;
+#endif
+         if( wait <= 0 )
+             return 0;
+         if( (ulong)wait < limit )
+             limit = wait;
+     }
+     return limit;
+#endif
 }
-#define DIGITAL
-#if defined DIGITAL
+
+#if defined EFL_DIGITAL_EDGE
+template<>
+bool List<Digital>::woken() {
+    return hooks.edges != 0;
+}
+#endif
+
+#endif //defined DIGITAL
+
+#if defined EFL_ANALOG
 
 /**
- * Provide a framework to respond to changes in state of digital inputs including 
- * debouncing the input for a specified time (in milliseconds.)
+ * Analog inputs, without blocking analogRead() calls. Each Analog watches
+ * an ADC channel (0..7, A0 is 0) and calls back when the sample rises to
+ * threshold (ROSE), falls below threshold - hysteresis (FELL) or, if delta
+ * isn't 0, has moved by delta or more since the last callback (MOVED.) The
+ * first sample only sets the state. A threshold of 0 never crosses.
+ *
+ * On AVR the ADC runs free, converting the watched channels round robin
+ * and storing each result from the conversion complete interrupt (the
+ * ADC_vect defined below). That only feeds the default List<Analog>, so
+ * adding an Analog to any other list (e.g. an EventLoop's) returns NAK. A
+ * pass checks the channels converted since the previous one. Elsewhere a
+ * pass takes a sample of every watched channel from the IO stub's
+ * analogSample(). Several Analogs may watch one channel.
  */
-
-class Digital
+class Analog
 {
 public:
-  typedef enum      /// interpreted state of the input
-  {
-    INACTIVE =      (1<<0),	//1
-    GOING_ACTIVE =  (1<<1),	//2
-    ACTIVE =        (1<<2),	//4
-    GOING_INACTIVE =(1<<3),	//8
-  } States;
+  typedef enum {      /// why the callback ran
+    ROSE,
+    FELL,
+    MOVED
+  } Change;
 
-  typedef enum/// input polarity
+private:
+  int     id;
+  uchar   channel;
+  uint    threshold;
+  uint    hysteresis;
+  uint    delta;
+  uint    value;          // latest sample
+  uint    reported;       // sample at the latest callback
+  bool    above;          // at or above threshold
+  bool    sampled;        // a sample has set the state
+
+public:
+  Analog(int id, uchar c, uint t, uint h = 0, uint d = 0):
+  id(id), channel(c), threshold(t), hysteresis(h), delta(d), value(0), reported(0), above(false), sampled(false)
   {
-    ACT_LO,
-    ACT_HI,
-  } Polarity;
+  };
+  int getID() { return id; };
+  uchar getChannel() { return channel; };
+  uint getValue() { return value; };
+  bool isAbove() { return above; };
+  bool update(uint sample);   // true if it called back
+  virtual bool callback(uint sample, Change why) {  /// callback on crossings and moves
+    if (verbose)
+      coln (X("Analog:"));
+    return false;
+  };
+  virtual ~Analog() {};
+};
 
-  typedef enum      /// valid digital input bits for an Arduino Uno
-  {                 // an enumerated value is chosen to
-      BIT_1 = 1,    // provide some guarantee that a valid
-      BIT_2,        // bit is specified.
-      BIT_3,
-      BIT_4,
-      BIT_5,
-      BIT_6,
-      BIT_7,
-      BIT_8,
-      BIT_9,
-      BIT_10,
-      BIT_11,
-      BIT_12,
-      BIT_13,
-      AN_0,    // pseudo digital inputs, I suppose.
-      AN_1,
-      AN_2,
-      AN_3,
-      AN_4,
-      AN_5,
-  } DigitalBit;
- 
+bool Analog::update(uint sample)
+{
+  Change why;
+  value = sample;
+  if (!sampled) {
+    sampled = true;
+    above = sample >= threshold;
+    reported = sample;
+    return false;
+  }
+  if (!above && sample >= threshold) {
+    above = true;
+    why = ROSE;
+  }
+  else if (above && sample + hysteresis < threshold) {
+    above = false;
+    why = FELL;
+  }
+  else if (delta && (sample > reported ? sample - reported : reported - sample) >= delta)
+    why = MOVED;
+  else
+    return false;
+  reported = sample;
+  callback(sample, why);
+  return true;
+}
 
-private:
-  int           id;
-  uint          debounce;
-  int           debounceCounter;
-  States        state;
-  Polarity      polarity;
-  DigitalBit    pin;
-  uchar         interestMask;
+template<> struct Hooks<Analog> {
+  enum {
+    CHANNELS = 8
+  };
+  uint            latest[CHANNELS]; // samples the pass works from
+  uchar           users[CHANNELS];  // Analogs per channel
+  uchar           watched;          // channels with users
+#if defined AVR
+  volatile uint   converted[CHANNELS];  // written by the ADC interrupt
+  volatile uchar  fresh;            // channels converted since the last pass
+  uchar           converting;       // channel of the conversion under way
+  uchar           started;          // channel the one after it converts
+#endif
+  Hooks(): watched(0) {
+    for (uchar c = 0; c < CHANNELS; c++)
+      users[c] = latest[c] = 0;
+#if defined AVR
+    fresh = 0;
+#endif
+  };
+  bool added(LL<Analog>* pLL, bool front);
+  void erased(LL<Analog>* pLL);
+  void setClock(Clock) {};
+  uchar take();                     // channels with a new sample in latest
+#if defined AVR
+  uchar after(uchar c) {            // the next watched channel, round robin
+    for (uchar i = 1; i <= CHANNELS; i++)
+      if (watched & (1 << ((c + i) % CHANNELS)))
+        return (c + i) % CHANNELS;
+    return c;
+  };
+  void done(uint sample);           // from the ADC interrupt
+#endif
+};
+
+bool Hooks<Analog>::added(LL<Analog>* pLL, bool)
+{
+  uchar c = pLL->item()->getChannel();
+  if (c >= CHANNELS)
+    return false;
+#if defined AVR
+  if (this != &List<Analog>::instance().hooks)
+    return false;                   // the ADC interrupt only feeds the default list
+  uchar sreg = SREG;
+  cli();
+  if (!(ADCSRA & (1 << ADIE))) {    // not running (the core may leave ADEN set)
+    converting = started = c;       // start free running on c
+    ADMUX = (1 << REFS0) | c;       // AVcc reference
+    ADCSRB = 0;
+    ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE)
+        | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);   // clock / 128
+  }
+  users[c]++;
+  watched |= 1 << c;
+  SREG = sreg;
+#else
+  users[c]++;
+  watched |= 1 << c;
+#endif
+  return true;
+}
+
+void Hooks<Analog>::erased(LL<Analog>* pLL)
+{
+  uchar c = pLL->item()->getChannel();
+  if (!--users[c])
+    watched &= ~(1 << c);           // the interrupt stops the ADC when none are left
+}
+
+uchar Hooks<Analog>::take()
+{
+#if defined AVR
+  uchar sreg = SREG;
+  cli();
+  uchar rc = fresh;
+  fresh = 0;
+  for (uchar c = 0; c < CHANNELS; c++)
+    if (rc & (1 << c))
+      latest[c] = converted[c];
+  SREG = sreg;
+  return rc;
+#else
+  for (uchar c = 0; c < CHANNELS; c++)
+    if (watched & (1 << c))
+      latest[c] = ::analogSample(c);
+  return watched;
+#endif
+}
 
-  
+#if defined AVR
+/*
+ * Free running, the next conversion has already started when a result is
+ * ready, so a new channel only takes effect the conversion after that.
+ */
+void Hooks<Analog>::done(uint sample)
+{
+  converted[converting] = sample;
+  fresh |= 1 << converting;
+  if (!watched) {
+    ADCSRA = 0;
+    return;
+  }
+  converting = started;
+  started = after(started);
+  ADMUX = (1 << REFS0) | started;
+}
+#endif
+
+template<>
+bool List<Analog>::onePass(ulong) {
+  if (!count)
+    return false;
+  uchar fresh = hooks.take();
+  bool  changed = false;
+  for (LL<Analog>* pLL = begin(); fresh && pLL != end(); pLL = pLL->next()) {
+    uchar c = pLL->item()->getChannel();
+    if (fresh & (1 << c))
+      changed |= pLL->item()->update(hooks.latest[c]);
+  }
+  return changed;
+}
+
+template<>
+void List<Analog>::doItems() {
+  doItems(0UL);                   // the time isn't used
+}
+
+/*
+ * On AVR the conversion complete interrupt wakes the processor; elsewhere
+ * every pass samples.
+ */
+template<>
+ulong List<Analog>::idleFor(ulong, ulong limit) {
+  if (!count)
+    return limit;
+#if defined AVR
+  return hooks.fresh ? 0 : limit;
+#else
+  return 1 < limit ? 1 : limit;
+#endif
+}
+
+#if defined AVR
+template<>
+bool List<Analog>::woken() {
+  return hooks.fresh != 0;
+}
+#endif
+
+#endif // defined EFL_ANALOG
 
+/*
+ * Idle puts off the next pass of a set of lists for as long as they allow
+ * (their idleFor()) and no longer than limit, and sleeps meanwhile. On AVR
+ * it uses SLEEP_MODE_IDLE, which keeps timer0 and so millis() running; its
+ * tick wakes the processor every millisecond to check the time and any
+ * interrupt that posts an Event or reports an edge ends the sleep early.
+ * Elsewhere it waits on the Wakeup, which post() and pinChanged() raise
+ * from other threads, and counts the time idled with millis(). There
+ * sleep() without a limit blocks until another thread raises the Wakeup
+ * when every list is empty. Define EFL_IDLE_DELAY when millis() is a stub
+ * that only delay() moves; sleep() then calls delay() instead. last and
+ * total count the milliseconds idled.
+ *
+ * Idle sleeps in milliseconds. Each list is asked at its own clock's time,
+ * and a micros() list's answer is rounded down to whole milliseconds; a
+ * list on any other clock can't be idled on.
+ */
+class Idle {
 public:
-  Digital( int id, DigitalBit b,int d = 1, Polarity p = ACT_HI, uchar interest = (INACTIVE|ACTIVE)):
-  id(id), debounce(d), debounceCounter(0), state(INACTIVE), polarity(p), pin(b), interestMask(interest)
+  ulong   last;                     // ms the latest sleep() idled
+  ulong   total;                    // ms idled in all
+  Idle(List<Event>& e, List<Timer>& t
+#if defined DIGITAL
+      , List<Digital>& d
+#endif
+#if defined EFL_ANALOG
+      , List<Analog>& a
+#endif
+      ):
+  last(0),total(0),events(e),timers(t)
+#if defined DIGITAL
+  ,inputs(d)
+#endif
+#if defined EFL_ANALOG
+  ,analogs(a)
+#endif
   {
-     pinMode(pin, INPUT);      // should this be done in setup?
-  };				// defaults: 1 ms debounce and active high polarity
-                    // and interest in transitions to inactive or active only
+  };
+  static Idle& instance() {         // for the default lists
+    static Idle rc(List<Event>::instance(), List<Timer>::instance()
+#if defined DIGITAL
+        , List<Digital>::instance()
+#endif
+#if defined EFL_ANALOG
+        , List<Analog>::instance()
+#endif
+        );
+    return rc;
+  };
+  ulong idleFor(ulong now, ulong limit) { // now is a millis() reading
+    limit = idleFor(events, now, limit);
+    limit = idleFor(timers, now, limit);
+#if defined DIGITAL
+    limit = idleFor(inputs, now, limit);
+#endif
+#if defined EFL_ANALOG
+    limit = idleFor(analogs, now, limit);
+#endif
+    return limit;
+  };
+  ulong sleep(ulong limit = ~0UL);  // idle until a pass is due, return ms idled
 
-  States getState() { return state;};
+private:
+  template<class Item>
+  static ulong idleFor(List<Item>& list, ulong ms, ulong limit) {
+    if (list.clock() == millis)
+      return list.idleFor(ms, limit);
+    assert(list.clock() == micros);   // Idle only knows ms and us
+    ulong us = limit < ~0UL / 1000 ? limit * 1000 : ~0UL;
+    us = list.idleFor(list.now(), us);
+    return us == ~0UL ? limit : us / 1000;
+  };
+  bool woken() {
+#if defined DIGITAL
+    if (inputs.woken())
+      return true;
+#endif
+#if defined EFL_ANALOG
+    if (analogs.woken())
+      return true;
+#endif
+    return events.woken();
+  };
+  Idle(const Idle&);
+  Idle& operator=(const Idle&);
 
-    /*
-     * I hate to pass in the flag to indicate that this is a 'significant' change worthy of a callback
-     * but the logic is so much easier where the states are managed.
-     */
-  void setState(States s) {
-      States oldState = state;
-      state=s;
-      if( interestMask & state)
-          callback(0, state, oldState);
+  List<Event>&    events;
+  List<Timer>&    timers;
+#if defined DIGITAL
+  List<Digital>&  inputs;
+#endif
+#if defined EFL_ANALOG
+  List<Analog>&   analogs;
+#endif
+};
+
+ulong Idle::sleep(ulong limit)
+{
+#if !defined AVR && !defined EFL_IDLE_DELAY
+  ulong seen = Wakeup::instance().raises(); // before the lists are checked
+#endif
+  ulong start = millis();
+  ulong ms = idleFor(start, limit);
+  if (ms) {
+#if defined AVR
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (millis() - start < ms && !woken())
+      sleep_mode();
+    ms = millis() - start;
+#elif defined EFL_IDLE_DELAY
+    delay(ms);
+#else
+    Wakeup::instance().wait(ms, seen);
+    ms = millis() - start;
+#endif
+  }
+  last = ms;
+  total += ms;
+  return ms;
+}
+
+/*
+ * EventLoop holds one List of each kind and runs them together. Nothing in
+ * it is static, so a program can keep several (e.g. one per simulated
+ * board) and run each independently of the others and of the default lists.
+ * tick() reads millis() once and hands the same time to every list on
+ * millis(); a list on another clock gets its own reading. Empty lists
+ * return straight away. It returns true if any callback ran or any
+ * input changed state, so a caller that gets false may sleep.
+ */
+class EventLoop {
+public:
+  List<Event>     events;
+  List<Timer>     timers;
+#if defined DIGITAL
+  List<Digital>   inputs;
+#endif
+#if defined EFL_ANALOG
+  List<Analog>    analogs;
+#endif
+  Idle            idle;             // sleep until these lists need a pass
+  EventLoop():
+  idle(events, timers
+#if defined DIGITAL
+      , inputs
+#endif
+#if defined EFL_ANALOG
+      , analogs
+#endif
+      ) {
   };
-  bool getSense() { return (polarity==ACT_HI)?digitalRead(pin):!digitalRead(pin); };
-  int getID() { return id; };
-  uint setDebounceCounter() { return debounceCounter = debounce; };
-  uint getDebounce() { return debounce; };
-  int decrementDebounce(uint delta) { return debounceCounter -= delta; };
-  virtual bool callback (ulong late, States newState, States oldState) {   /// callback on state changes
+  bool tick() {
+    ulong now = millis();
+    bool  work = events.doItems(events.now(now));
+    work |= timers.doItems(timers.now(now));
+#if defined DIGITAL
+    work |= inputs.doItems(inputs.now(now));
+#endif
+#if defined EFL_ANALOG
+    work |= analogs.doItems(analogs.now(now));
+#endif
+    return work;
+  };
+  void doItems() {
+    tick();
+  };
+};
 
-    if (verbose)
-	  coln (X("Digital:"));
+// tick() for the default lists
+inline bool run()
+{
+  ulong now = millis();
+  bool  work = List<Event>::instance().doItems(List<Event>::instance().now(now));
+  work |= List<Timer>::instance().doItems(List<Timer>::instance().now(now));
+#if defined DIGITAL
+  work |= List<Digital>::instance().doItems(List<Digital>::instance().now(now));
+#endif
+#if defined EFL_ANALOG
+  work |= List<Analog>::instance().doItems(List<Analog>::instance().now(now));
+#endif
+  return work;
+}
+
+/*
+ * A static graph: the Timers and inputs of a program whose set is fixed at
+ * build time, declared as one type and run without Lists. Each entry is a
+ * template whose last argument is the rest of the table, e.g.
+ *
+ *  void blink(ulong late);
+ *  void button(bool active);
+ *  StaticGraph< Every<blink, 500, OnPin<Digital::BIT_3, button, 5> > > panel;
+ *
+ * Periods, pins, debounce times and callbacks are template arguments, so
+ * they are constants in the code (flash on AVR) and the calls are direct.
+ * Each entry keeps only its countdown in RAM; nothing is add()ed and no
+ * nodes are walked. PINS is the mask of the pins the table reads, known at
+ * compile time. doItems() runs the table unrolled, one inline step per
+ * entry, and may run next to the Lists in the loop. An Every calls its
+ * function every period (late as a Timer's) and an OnPin reports settled
+ * changes only.
+ */
+struct StaticEnd {                  // terminates a table
+  static const ulong PINS = 0;
+  void begin() {
+  };
+  bool step(ulong, ulong) {
     return false;
   };
-  virtual ~Digital() {}; // nothing to destroy
+  ulong idle(ulong limit) {
+    return limit;
+  };
 };
 
-template<>
-void LL<Digital>::doItems() {
-     static ulong prevMillis = 0;    // start when execution starts
-     ulong   nowMillis = millis();   // time now
-     uint   deltaMillis = nowMillis - prevMillis;
- 
-     if(!deltaMillis)
-       return;
- 
-//     if(verbose) walk();
-     
- // iterate through timers to see which ones have downcounted to or beyond zero
-     for(LL<Digital>* pLL = begin(); pLL != end(); pLL = pLL->next()) {
-       // scan all digital inputs
-         switch(pLL->pItem->getState()) {
-             case Digital::INACTIVE:
-                if( pLL->pItem->getSense()) {
-                    Printf( "pItem->id(%d) going active.\n", pLL->pItem->getID());
-                    if( pLL->pItem->getDebounce() > 0 ) {
-                        pLL->pItem->setState(Digital::GOING_ACTIVE);
-                        pLL->pItem->setDebounceCounter();
-                    }
-                    else {
-                        pLL->pItem->setState(Digital::ACTIVE);
-                    }
-                }
-                break;
-
-             case Digital::GOING_INACTIVE:
-             case Digital::GOING_ACTIVE:
-                if( pLL->pItem->decrementDebounce(deltaMillis) <= 0) {
-                    Printf("Debounce complete id(%d)\n", pLL->pItem->getID());
-                    if( pLL->pItem->getSense() )
-                        pLL->pItem->setState(Digital::ACTIVE);
-                    else
-                        pLL->pItem->setState(Digital::INACTIVE);
-                 }
-                 break;
-
-             case Digital::ACTIVE:
-                if( !pLL->pItem->getSense()) {
-                    Printf( "pItem->id(%d) going inactive.\n", pLL->pItem->getID());
-                    if( pLL->pItem->getDebounce() > 0 ) {
-                        pLL->pItem->setState(Digital::GOING_INACTIVE);
-                        pLL->pItem->setDebounceCounter();
-                    }
-                    else {
-                        pLL->pItem->setState(Digital::INACTIVE);
-                    }
-                }
-                 break;
-
-             default:
-                 pLL->pItem->setState(Digital::INACTIVE); // what else to do here?
-                 break;
-          }
-      }
-    prevMillis = nowMillis;
-}
+template<void (*Fn)(ulong late), ulong Period, class Next = StaticEnd>
+struct Every: Next {
+  typedef char periodCheck[Period > 0 ? 1 : -1];
+  ulong left;                       // ms until the next call
+  Every():
+  left(Period) {
+  };
+  bool step(ulong delta, ulong levels) {
+    bool work = false;
+    if (left <= delta) {
+      ulong late = delta - left;
+      Fn(late);
+      left = late < Period ? Period - late : 1; // as Timer's RELATIVE rule
+      work = true;
+    }
+    else
+      left -= delta;
+    return Next::step(delta, levels) || work;
+  };
+  ulong idle(ulong limit) {
+    return Next::idle(left < limit ? left : limit);
+  };
+};
 
-#endif //defined DIGITAL
+#if defined DIGITAL
+template<Digital::DigitalBit Pin, void (*Fn)(bool active), uint Debounce = 1,
+  Digital::Polarity P = Digital::ACT_HI, class Next = StaticEnd>
+struct OnPin: Next {
+  static const ulong PINS = Next::PINS | 1UL << Pin;
+  bool  active;                     // settled state
+  uint  left;                       // ms of debounce to go, 0 when settled
+  OnPin():
+  active(false),left(0) {
+  };
+  void begin() {
+    pinMode(Pin, INPUT);
+    Next::begin();
+  };
+  bool step(ulong delta, ulong levels) {
+#if defined EFL_DIGITAL_PORTS
+    bool sense = (levels >> Pin & 1) == (P == Digital::ACT_HI);
+#else
+    bool sense = digitalRead(Pin) == (P == Digital::ACT_HI);
+#endif
+    bool work = false;
+    if (left) {                     // debouncing, sample at the end
+      left = delta < left ? left - delta : 0;
+      work = !left && sense != active;
+    }
+    else if (sense != active) {
+      left = Debounce;
+      work = !left;
+    }
+    if (work) {
+      active = sense;
+      Fn(active);
+    }
+    return Next::step(delta, levels) || work;
+  };
+  ulong idle(ulong limit) {
+    return limit ? 1 : 0;           // polled every ms
+  };
+};
+#endif
+
+template<class Table> class StaticGraph: public Table {
+public:
+  static const ulong PINS = Table::PINS;
+  StaticGraph():
+  prev(0) {
+  };
+  void begin(ulong now = millis()) { // set up the pins and start the clock
+    Table::begin();
+    prev = now;
+  };
+  bool doItems(ulong now) {
+    ulong delta = now - prev;
+    if (!delta)
+      return false;
+    prev = now;
+#if defined EFL_DIGITAL_PORTS
+    return Table::step(delta, PINS ? readPins() : 0);
+#else
+    return Table::step(delta, 0);
+#endif
+  };
+  bool doItems() {
+    return doItems(millis());
+  };
+  ulong idleFor(ulong now, ulong limit) { // ms until doItems() has work
+    ulong gone = now - prev;
+    ulong wait = Table::idle(limit > ~0UL - gone ? ~0UL : limit + gone);
+    return wait > gone ? wait - gone : 0;
+  };
+
+private:
+  StaticGraph(const StaticGraph&);
+  StaticGraph& operator=(const StaticGraph&);
+
+  ulong prev;                       // time of the previous pass
+};
 
 } // namespace efl
 
+#if defined AVR && defined EFL_DIGITAL_EDGE
+/*
+ * Pin change vectors, one per port. Each reports the pins that changed
+ * since its previous interrupt to the default List<Digital>.
+ */
+static void eflPortChanged(efl::uchar now, efl::uchar& was, efl::uchar firstPin)
+{
+  efl::uchar changed = now ^ was;
+  was = now;
+  for (efl::uchar b = 0; changed; b++, changed >>= 1)
+    if (changed & 1)
+      efl::pinChanged(firstPin + b);
+}
+
+ISR(PCINT0_vect) {                  // port B, pins 8..13
+  static efl::uchar was;
+  eflPortChanged(PINB & 0x3F, was, 8);
+}
+ISR(PCINT1_vect) {                  // port C, A0..A5
+  static efl::uchar was;
+  eflPortChanged(PINC & 0x3F, was, 14);
+}
+ISR(PCINT2_vect) {                  // port D, pins 0..7
+  static efl::uchar was;
+  eflPortChanged(PIND, was, 0);
+}
+#endif // defined AVR && defined EFL_DIGITAL_EDGE
+
+#if defined AVR && defined EFL_ANALOG
+ISR(ADC_vect) {                     // a conversion for the default List<Analog>
+  efl::List<efl::Analog>::instance().hooks.done(ADC);
+}
+#endif // defined AVR && defined EFL_ANALOG
 
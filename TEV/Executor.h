@@ -0,0 +1,176 @@
+#if !defined AVR // host only, runs List passes on a pool of threads
+#if !defined EFL_EXECUTOR_H
+#define EFL_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace efl { // event framework library
+
+/**
+ * Executor runs the passes of many EventLoops (typically one per simulated
+ * board) and standalone Lists on a pool of worker threads. Include it after
+ * EventFramework.h.
+ *
+ * Each registered EventLoop is one task that runs its tick(), and each
+ * standalone List is one task that runs its doItems(). On every pass the tasks are dealt out
+ * round robin to the workers' queues; a worker that runs out of its own
+ * work steals from the back of the other queues, so one slow board doesn't
+ * hold up a whole core's worth of others.
+ *
+ * Ordering guarantees:
+ *  - a task's pass runs on exactly one thread and its callbacks run in list
+ *    order, exactly as tick() or List::doItems() does when called directly.
+ *    The lists of an EventLoop run one after the other in the one task, so
+ *    a callback may add to or post on another list of its own EventLoop.
+ *  - passes of the same task never overlap. Everything done in pass N of
+ *    doItems() happens before anything in pass N+1 (doItems() returns only
+ *    when every task of the pass has finished.)
+ *  - there is no ordering between different tasks within a pass, so tasks
+ *    that share an Item, a node or other mutable data must not be
+ *    registered separately; register an EventLoop whole rather than its
+ *    lists one by one.
+ *
+ * Lists must only be registered (add()) between passes.
+ */
+class Executor {
+public:
+  explicit Executor(unsigned threads = std::thread::hardware_concurrency());
+  ~Executor();
+  template<class Item> void add(List<Item>& list) {   // run list on every pass
+    Task t = { &Executor::pass<Item>, &list };
+    tasks.push_back(t);
+  };
+  void add(EventLoop& loop) {              // all the lists of an EventLoop, in one task
+    Task t = { &Executor::tick, &loop };
+    tasks.push_back(t);
+  };
+  void doItems();                           // one pass of every list, then return
+  unsigned threads() {
+    return (unsigned)workers.size();
+  };
+
+private:
+  struct Task {
+    void  (*run)(void*);
+    void* list;                             // the List or EventLoop
+  };
+  struct Worker {
+    std::mutex          lock;
+    std::deque<Task*>   queue;
+  };
+  template<class Item> static void pass(void* list) {
+    static_cast<List<Item>*>(list)->doItems();
+  };
+  static void tick(void* loop) {
+    static_cast<EventLoop*>(loop)->tick();
+  };
+  bool take(unsigned self, Task*& pTask);   // own queue first, then steal
+  void work(unsigned self);                 // worker thread body
+
+  Executor(const Executor&);
+  Executor& operator=(const Executor&);
+
+  std::vector<Task>         tasks;
+  std::vector<Worker*>      workers;
+  std::vector<std::thread>  pool;
+  std::mutex                lock;           // guards generation and stop
+  std::condition_variable   wake;           // a pass has started (or stop)
+  std::condition_variable   done;           // the pass has finished
+  unsigned                  generation;     // number of passes started
+  bool                      stop;
+  std::atomic<int>          pending;        // tasks of this pass not yet finished
+};
+
+Executor::Executor(unsigned threads):
+generation(0),stop(false),pending(0)
+{
+  if (!threads)
+    threads = 1;
+  for (unsigned i = 0; i < threads; i++)
+    workers.push_back(new Worker);
+  for (unsigned i = 0; i < threads; i++)
+    pool.push_back(std::thread(&Executor::work, this, i));
+}
+
+Executor::~Executor()
+{
+  {
+    std::lock_guard<std::mutex> l(lock);
+    stop = true;
+  }
+  wake.notify_all();
+  for (unsigned i = 0; i < pool.size(); i++)
+    pool[i].join();
+  for (unsigned i = 0; i < workers.size(); i++)
+    delete workers[i];
+}
+
+bool Executor::take(unsigned self, Task*& pTask)
+{
+  for (unsigned i = 0; i < workers.size(); i++) {
+    Worker* pW = workers[(self + i) % workers.size()];
+    std::lock_guard<std::mutex> l(pW->lock);
+    if (pW->queue.empty())
+      continue;
+    if (!i) {                               // own work from the front
+      pTask = pW->queue.front();
+      pW->queue.pop_front();
+    }
+    else {                                  // steal from the back
+      pTask = pW->queue.back();
+      pW->queue.pop_back();
+    }
+    return true;
+  }
+  return false;
+}
+
+void Executor::work(unsigned self)
+{
+  unsigned seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> l(lock);
+      while (!stop && generation == seen)
+        wake.wait(l);
+      if (stop)
+        return;
+      seen = generation;
+    }
+    Task* pTask;
+    while (take(self, pTask)) {
+      pTask->run(pTask->list);
+      if (--pending == 0) {
+        std::lock_guard<std::mutex> l(lock);
+        done.notify_all();
+      }
+    }
+  }
+}
+
+void Executor::doItems()
+{
+  if (tasks.empty())
+    return;
+  pending = (int)tasks.size();              // before any task can be taken
+  for (unsigned i = 0; i < tasks.size(); i++) {
+    Worker* pW = workers[i % workers.size()];
+    std::lock_guard<std::mutex> l(pW->lock);
+    pW->queue.push_back(&tasks[i]);
+  }
+  std::unique_lock<std::mutex> l(lock);
+  generation++;
+  wake.notify_all();
+  while (pending != 0)
+    done.wait(l);
+}
+
+} // namespace efl
+
+#endif // !defined EFL_EXECUTOR_H
+#endif // !defined AVR
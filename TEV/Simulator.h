@@ -0,0 +1,161 @@
+#if !defined AVR // host only, runs Lists in virtual time
+#if !defined EFL_SIMULATOR_H
+#define EFL_SIMULATOR_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+namespace efl { // event framework library
+
+/**
+ * Simulator runs the default Lists (efl::run()) or those of an EventLoop in
+ * virtual time. Include it after EventFramework.h.
+ *
+ * Rather than stepping the clock a millisecond per pass, after each pass it
+ * moves the clock straight on to the first of:
+ *  - the next Timer deadline,
+ *  - the end of the next Digital debounce,
+ *  - the next edge of the script,
+ * and runs the next pass there. Lists with Events that stay listed need a
+ * pass every millisecond, as they would on the hardware. An hour of inputs
+ * that change a few times a second and timers that fire every second takes
+ * some thousands of passes.
+ *
+ * The clock is the program's stand in for millis(); the Simulator is handed
+ * the variable it returns and owns it from then on. The script sets input
+ * levels through drive, which plays the hardware (and, with
+ * EFL_DIGITAL_EDGE, reports the pin change.) Lists on other clocks don't
+ * advance.
+ *
+ * A script file has one edge per line, "ms pin level", in ms since the
+ * Simulator was made. Blank lines and lines starting with # are skipped and
+ * the edges needn't be in order.
+ */
+class Simulator {
+public:
+  typedef void (*Drive)(uint pin, bool level);  // sets an input
+  Simulator(ulong& clock, Drive drive);         // the default lists
+  Simulator(EventLoop& loop, ulong& clock, Drive drive);
+  void at(ulong when, uint pin, bool level);    // add an edge to the script
+  bool load(const char* path);                  // add a script file's edges
+  ulong run(ulong ms);                          // advance ms, return passes run
+  ulong elapsed() {                             // ms since the Simulator was made
+    return clock - origin;
+  };
+  ulong passes;                                 // run in all
+
+private:
+  struct Edge {
+    ulong when;
+    uint  pin;
+    bool  level;
+    bool operator<(const Edge& e) const {
+      return when < e.when;
+    };
+  };
+  bool pass();
+  ulong settleFor(ulong limit);                 // ms until the lists need a pass
+
+  Simulator(const Simulator&);
+  Simulator& operator=(const Simulator&);
+
+  EventLoop*          pLoop;                    // 0 for the default lists
+  ulong&              clock;
+  Drive               drive;
+  ulong               origin;
+  std::vector<Edge>   script;                   // in time order
+  size_t              next;                     // first edge not yet driven
+};
+
+Simulator::Simulator(ulong& clock, Drive drive):
+passes(0),pLoop(0),clock(clock),drive(drive),origin(clock),next(0)
+{
+}
+
+Simulator::Simulator(EventLoop& loop, ulong& clock, Drive drive):
+passes(0),pLoop(&loop),clock(clock),drive(drive),origin(clock),next(0)
+{
+}
+
+void Simulator::at(ulong when, uint pin, bool level)
+{
+  Edge e = { when, pin, level };
+  script.insert(std::upper_bound(script.begin() + next, script.end(), e), e);
+}
+
+bool Simulator::load(const char* path)
+{
+  FILE* pF = fopen(path, "r");
+  if (!pF)
+    return false;
+  char  line[80];
+  bool  rc = true;
+  while (rc && fgets(line, sizeof line, pF)) {
+    unsigned long when;
+    unsigned      pin, level;
+    char          c;
+    if (sscanf(line, " %c", &c) != 1 || c == '#')
+      continue;
+    if (sscanf(line, "%lu %u %u", &when, &pin, &level) == 3)
+      at(when, pin, level != 0);
+    else
+      rc = false;                               // not an edge
+  }
+  fclose(pF);
+  return rc;
+}
+
+bool Simulator::pass()
+{
+  passes++;
+  return pLoop ? pLoop->tick() : efl::run();
+}
+
+ulong Simulator::settleFor(ulong limit)
+{
+  if (pLoop) {
+    limit = pLoop->events.settleFor(clock, limit);
+    limit = pLoop->timers.settleFor(clock, limit);
+#if defined DIGITAL
+    limit = pLoop->inputs.settleFor(clock, limit);
+#endif
+#if defined EFL_ANALOG
+    limit = pLoop->analogs.settleFor(clock, limit);
+#endif
+    return limit;
+  }
+  limit = List<Event>::instance().settleFor(clock, limit);
+  limit = List<Timer>::instance().settleFor(clock, limit);
+#if defined DIGITAL
+  limit = List<Digital>::instance().settleFor(clock, limit);
+#endif
+#if defined EFL_ANALOG
+  limit = List<Analog>::instance().settleFor(clock, limit);
+#endif
+  return limit;
+}
+
+ulong Simulator::run(ulong ms)
+{
+  ulong end = clock + ms;
+  ulong start = passes;
+  for (;;) {
+    for (; next < script.size() && script[next].when <= elapsed(); next++)
+      drive(script[next].pin, script[next].level);
+    pass();
+    if ((long)(end - clock) <= 0)
+      break;
+    ulong limit = end - clock;
+    if (next < script.size() && script[next].when - elapsed() < limit)
+      limit = script[next].when - elapsed();
+    ulong wait = settleFor(limit);
+    clock += wait ? wait : 1;                   // passes at least 1 ms apart
+  }
+  return passes - start;
+}
+
+} // namespace efl
+
+#endif // !defined EFL_SIMULATOR_H
+#endif // !defined AVR
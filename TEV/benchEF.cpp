@@ -0,0 +1,458 @@
+// Host benchmarks for the framework. Build from Debug/ with 'make benchEF'
+// (optimized, unlike the tests) and run ./benchEF, or ./benchEF --csv for
+// one "build,benchmark,n,value,unit" row per result. benchSingly, benchWheel
+// and benchHeap build the same benchmarks against the other node layout and
+// Timer backends, and benchFn with EFL_FN_CALLBACKS (no vtables in Timer
+// and Digital; StaticTimer has none in any build.)
+
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <chrono>
+using namespace std;
+
+typedef unsigned long ulong;
+typedef unsigned int  uint;
+
+#define co(x) cout << (x)
+#define coln(x) {cout << (x) << endl;}
+#define X(x) x
+#define F(x) x
+#define Printf printf
+
+// just enough of the Arduino stubs for EventFramework.h
+ulong millisVal=0;
+unsigned long millis() {
+    return millisVal;
+}
+unsigned long micros() {
+    return millisVal * 1000;
+}
+void delay(unsigned int n) {
+    millisVal+=n;
+}
+static const int INPUT=1;
+void pinMode(int pin, int direction) {
+}
+bool digitalRead(unsigned int p) {
+    return false;
+}
+
+#include <assert.h>
+static bool verbose=false;
+
+#include "EventFramework.h"
+
+static const int ITEMS=1000;    // per list
+static const int PASSES=10000;
+static volatile ulong sink;     // keeps the counts observable
+
+static const char* build =      // what was benchmarked
+#if defined EFL_LL_SINGLY
+    "singly"
+#else
+    "doubly"
+#endif
+#if defined EFL_TIMER_WHEEL
+    "+wheel"
+#elif defined EFL_TIMER_HEAP
+    "+heap"
+#else
+    "+countdown"
+#endif
+#if defined EFL_FN_CALLBACKS
+    "+fn";
+#else
+    "";
+#endif
+
+static bool csv = false;
+
+// one result, value in unit (ns per operation, per second or bytes)
+void report(const char* benchmark, int n, double value, const char* unit)
+{
+    if(csv)
+        printf("%s,%s,%d,%.2f,%s\n", build, benchmark, n, value, unit);
+    else
+        printf("  %-16s %6d %10.2f %s\n", benchmark, n, value, unit);
+}
+
+double since(chrono::steady_clock::time_point start)   // ns
+{
+    chrono::duration<double, nano> ns = chrono::steady_clock::now() - start;
+    return ns.count();
+}
+
+// per call cost in ns of PASSES passes of list
+template<class Item> double timePasses(efl::List<Item>& list)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i=0; i<PASSES; i++)
+        list.doItems();
+    chrono::duration<double, nano> ns = chrono::steady_clock::now() - start;
+    return ns.count() / ((double)ITEMS * PASSES);
+}
+
+/*
+ * Dispatch: the same repeating callback reached through Event's vtable,
+ * through FnEvent's function pointer and bound at compile time on a
+ * concrete Item type.
+ */
+class VirtualCount:
+    public efl::Event {
+public:
+    ulong   count;
+    VirtualCount(): count(0) {
+    };
+    virtual bool callback() {
+        count++;
+        return true;
+    };
+};
+
+class FnCount:
+    public efl::FnEvent {
+public:
+    ulong   count;
+    FnCount(): efl::FnEvent(bump), count(0) {
+    };
+    static bool bump(efl::FnEvent* pE) {
+        static_cast<FnCount*>(pE)->count++;
+        return true;
+    };
+};
+
+class StaticCount {
+public:
+    ulong   count;
+    StaticCount(): count(0) {
+    };
+    bool callback() {
+        count++;
+        return true;
+    };
+};
+
+template<class Item, class Count> double dispatch()
+{
+    static Count            counts[ITEMS];
+    static efl::LL<Item>*   nodes[ITEMS];
+    efl::List<Item>         list;
+    for(int i=0; i<ITEMS; i++)
+    {
+        nodes[i] = new efl::LL<Item>(&counts[i]);
+        nodes[i]->add(list);
+    }
+    double rc = timePasses(list);
+    for(int i=0; i<ITEMS; i++)
+    {
+        sink += counts[i].count;
+        nodes[i]->erase(list);
+        delete nodes[i];
+    }
+    return rc;
+}
+
+/*
+ * Storage: the same Items linked by LL nodes and held in an EventPool.
+ */
+static const int POOLED=250;    // an EventPool holds fewer than 255
+
+double nodes()
+{
+    static StaticCount              counts[POOLED];
+    static efl::LL<StaticCount>*    nodes[POOLED];
+    efl::List<StaticCount>          list;
+    for(int i=0; i<POOLED; i++)
+    {
+        nodes[i] = new efl::LL<StaticCount>(&counts[i]);
+        nodes[i]->add(list);
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i=0; i<PASSES; i++)
+        list.doItems();
+    chrono::duration<double, nano> ns = chrono::steady_clock::now() - start;
+    for(int i=0; i<POOLED; i++)
+    {
+        sink += counts[i].count;
+        nodes[i]->erase(list);
+        delete nodes[i];
+    }
+    return ns.count() / ((double)POOLED * PASSES);
+}
+
+double pooled()
+{
+    static efl::EventPool<StaticCount, POOLED> pool;
+    while(pool.add())
+        ;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i=0; i<PASSES; i++)
+        pool.doItems();
+    chrono::duration<double, nano> ns = chrono::steady_clock::now() - start;
+    for(StaticCount* pC = pool.first(); pC; pC = pool.next(pC))
+        sink += pC->count;
+    return ns.count() / ((double)POOLED * PASSES);
+}
+
+/*
+ * List operations: add(), push() and erase() of a batch of nodes on a list
+ * already holding n. The batch is erased oldest first, so with singly
+ * linked nodes each erase() scans past the n held ones.
+ */
+static const int BATCH=100;
+static const int ROUNDS=1000;
+
+void listOps(int n)
+{
+    efl::Event                  item;
+    efl::List<efl::Event>       list;
+    efl::LL<efl::Event>*        held[ITEMS];
+    efl::LL<efl::Event>*        batch[BATCH];
+    double                      add = 0, push = 0, erase = 0;
+    for(int i=0; i<n; i++)
+    {
+        held[i] = new efl::LL<efl::Event>(&item);
+        held[i]->add(list);
+    }
+    for(int i=0; i<BATCH; i++)
+        batch[i] = new efl::LL<efl::Event>(&item);
+    for(int r=0; r<ROUNDS; r++)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for(int i=0; i<BATCH; i++)
+            batch[i]->add(list);
+        add += since(start);
+        start = chrono::steady_clock::now();
+        for(int i=0; i<BATCH; i++)
+            batch[i]->erase(list);
+        erase += since(start);
+        start = chrono::steady_clock::now();
+        for(int i=0; i<BATCH; i++)
+            batch[i]->push(list);
+        push += since(start);
+        for(int i=0; i<BATCH; i++)
+            batch[i]->erase(list);
+    }
+    for(int i=0; i<BATCH; i++)
+        delete batch[i];
+    for(int i=0; i<n; i++)
+    {
+        held[i]->erase(list);
+        delete held[i];
+    }
+    report("list.add", n, add / ((double)BATCH * ROUNDS), "ns");
+    report("list.push", n, push / ((double)BATCH * ROUNDS), "ns");
+    report("list.erase", n, erase / ((double)BATCH * ROUNDS), "ns");
+}
+
+/*
+ * Timers: n periodic timers with period n and staggered deadlines, so one
+ * expires on every 1 ms tick. The cost is per tick.
+ */
+class TickTimer:
+    public efl::Timer {
+public:
+    ulong   count;
+#if defined EFL_FN_CALLBACKS
+    TickTimer(): efl::Timer(1, 0, tick), count(0) {
+    };
+    static bool tick(efl::Timer* pT, ulong, ulong) {
+        static_cast<TickTimer*>(pT)->count++;
+        return true;
+    };
+#else
+    TickTimer(): count(0) {
+    };
+    virtual bool callback(ulong late) {
+        count++;
+        return true;
+    };
+#endif
+};
+
+class StaticTick:
+    public efl::StaticTimer<StaticTick> {
+public:
+    ulong   count;
+    StaticTick(): count(0) {
+    };
+    bool callback(ulong late) {
+        count++;
+        return true;
+    };
+};
+
+void timers(int n)
+{
+    static TickTimer            items[ITEMS];
+    efl::LL<efl::Timer>*        nodes[ITEMS];
+    efl::List<efl::Timer>       list;
+    list.doItems();
+    for(int i=0; i<n; i++)
+    {
+        items[i].setCounter(i+1);
+        items[i].setPeriod(n);
+        nodes[i] = new efl::LL<efl::Timer>(&items[i]);
+        nodes[i]->add(list);
+    }
+    for(int i=0; i<n; i++)      // settle
+    {
+        millisVal++;
+        list.doItems();
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i=0; i<PASSES; i++)
+    {
+        millisVal++;
+        list.doItems();
+    }
+    double ns = since(start);
+    for(int i=0; i<n; i++)
+    {
+        sink += items[i].count;
+        nodes[i]->erase(list);
+        delete nodes[i];
+    }
+    report("timer.tick", n, ns / PASSES, "ns");
+}
+
+/*
+ * Timer dispatch: ITEMS timers with period 1, so all of them expire on
+ * every tick. The cost is per callback, through the vtable or, in benchFn,
+ * through the stored function; a List<StaticTick> calls it directly and
+ * always down counts.
+ */
+template<class Item, class T>
+double timerDispatch()
+{
+    static T                    items[ITEMS];
+    efl::LL<Item>*              nodes[ITEMS];
+    efl::List<Item>             list;
+    list.doItems();
+    for(int i=0; i<ITEMS; i++)
+    {
+        items[i].setCounter(1);
+        items[i].setPeriod(1);
+        nodes[i] = new efl::LL<Item>(&items[i]);
+        nodes[i]->add(list);
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i=0; i<PASSES; i++)
+    {
+        millisVal++;
+        list.doItems();
+    }
+    double ns = since(start);
+    for(int i=0; i<ITEMS; i++)
+    {
+        sink += items[i].count;
+        nodes[i]->erase(list);
+        delete nodes[i];
+    }
+    return ns / ((double)ITEMS * PASSES);
+}
+
+/*
+ * Digital inputs: n polled inputs spread over the pins, none changing. The
+ * cost is per 1 ms pass.
+ */
+void inputs(int n)
+{
+    efl::Digital*               items[ITEMS];
+    efl::LL<efl::Digital>*      nodes[ITEMS];
+    efl::List<efl::Digital>     list;
+    list.doItems();
+    for(int i=0; i<n; i++)
+    {
+        items[i] = new efl::Digital(i, (efl::Digital::DigitalBit)(efl::Digital::BIT_2 + i % 18), 5);
+        nodes[i] = new efl::LL<efl::Digital>(items[i]);
+        nodes[i]->add(list);
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i=0; i<PASSES; i++)
+    {
+        millisVal++;
+        list.doItems();
+    }
+    double ns = since(start);
+    for(int i=0; i<n; i++)
+    {
+        nodes[i]->erase(list);
+        delete nodes[i];
+        delete items[i];
+    }
+    report("digital.pass", n, ns / PASSES, "ns");
+}
+
+/*
+ * End to end: two one shot Events that push each other back on the
+ * default list, run by efl::run() along with the (empty) Timer and Digital
+ * lists. One event per run().
+ */
+class Relay:
+    public efl::Event {
+public:
+    efl::LL<efl::Event>*    pOther;
+    ulong                   count;
+    Relay(): pOther(0), count(0) {
+    };
+    virtual bool callback() {
+        count++;
+        pOther->push();         // at the front, so it runs on the next pass
+        return false;
+    };
+};
+
+void relay()
+{
+    static const int EVENTS=1000000;
+    Relay               ping, pong;
+    efl::LL<efl::Event> lping(&ping), lpong(&pong);
+    ping.pOther = &lpong;
+    pong.pOther = &lping;
+    lping.add();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i=0; i<EVENTS; i++)
+        efl::run();
+    double ns = since(start);
+    sink += ping.count + pong.count;
+    efl::List<efl::Event>::instance().begin()->erase();
+    report("loop.events", 2, EVENTS / ns * 1e9, "per_s");
+}
+
+int main(int argc, char* argv[])
+{
+    csv = argc > 1 && !strcmp(argv[1], "--csv");
+    if(csv)
+        printf("build,benchmark,n,value,unit\n");
+    else
+        printf("%s, ns per callback or operation\n", build);
+
+    report("dispatch.virtual", ITEMS, dispatch<efl::Event, VirtualCount>(), "ns");
+    report("dispatch.fnptr", ITEMS, dispatch<efl::FnEvent, FnCount>(), "ns");
+    report("dispatch.static", ITEMS, dispatch<StaticCount, StaticCount>(), "ns");
+    report("size.virtual", 1, sizeof(VirtualCount), "bytes");
+    report("size.fnptr", 1, sizeof(FnCount), "bytes");
+    report("size.static", 1, sizeof(StaticCount), "bytes");
+    report("dispatch.timer", ITEMS, timerDispatch<efl::Timer, TickTimer>(), "ns");
+    report("dispatch.stimer", ITEMS, timerDispatch<StaticTick, StaticTick>(), "ns");
+    report("size.timer", 1, sizeof(efl::Timer), "bytes");
+    report("size.stimer", 1, sizeof(efl::StaticTimer<StaticTick>), "bytes");
+    report("size.digital", 1, sizeof(efl::Digital), "bytes");
+    report("size.sdigital", 1, sizeof(efl::StaticDigital<StaticTick>), "bytes");
+
+    report("storage.nodes", POOLED, nodes(), "ns");
+    report("storage.pool", POOLED, pooled(), "ns");
+    report("size.nodes", 1, sizeof(StaticCount) + sizeof(efl::LL<StaticCount>), "bytes");
+    report("size.pool", 1, sizeof(efl::EventPool<StaticCount, POOLED>) / POOLED, "bytes");
+
+    for(int n=10; n<=ITEMS; n*=10)
+        listOps(n);
+    for(int n=10; n<=ITEMS; n*=10)
+        timers(n);
+    for(int n=1; n<=16; n*=4)
+        inputs(n);
+    relay();
+    return 0;
+}
@@ -0,0 +1,287 @@
+// Monte Carlo debounce tuning. Build from Debug/ with 'make debounceMC' and
+// run ./debounceMC -h for the options.
+//
+// Each trial generates a random bouncy, noisy input trace with a known set
+// of true presses and replays it through a fresh List<Recorder> for each
+// debounce setting, one millisecond per pass. Trials run in parallel on
+// all cores; every thread has its own clock and input level, so the lists
+// are independent. Per debounce setting it reports the true transitions,
+// the transitions detected in time, those missed, the false triggers and
+// the detection latency. A trial's trace depends only on the seed and the
+// trial number, so results don't depend on the number of threads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+using namespace std;
+
+typedef unsigned long ulong;
+typedef unsigned int  uint;
+
+#define co(x) printf("%s", (x))
+#define coln(x) printf("%s\n", (x))
+#define X(x) x
+#define F(x) x
+#define Printf printf
+
+// the Arduino stubs, per thread
+static thread_local ulong   millisVal=0;
+static thread_local bool    level=false;    // the one input
+unsigned long millis() {
+    return millisVal;
+}
+unsigned long micros() {
+    return millisVal * 1000;
+}
+void delay(unsigned int n) {
+    millisVal+=n;
+}
+static const int INPUT=1;
+void pinMode(int pin, int direction) {
+}
+bool digitalRead(unsigned int p) {
+    return level;
+}
+
+#include <assert.h>
+static bool verbose=false;
+
+#include "EventFramework.h"
+
+struct Options {
+    int     trials;
+    int     presses;        // true presses per trial
+    int     bounces;        // most bounce pulses after each true edge
+    int     bounceMs;       // window after an edge the bounces fall in
+    double  noise;          // glitches per second while the input is settled
+    ulong   seed;
+    bool    csv;
+    vector<int> debounce;   // settings to compare, ms
+};
+
+/*
+ * A trace: the input level for each ms and the true edges (rising first,
+ * then alternating.)
+ */
+struct Trace {
+    vector<bool>    level;
+    vector<ulong>   edges;
+};
+
+void generate(const Options& o, int trial, Trace& t)
+{
+    mt19937 rng(o.seed * 1000003UL + trial);
+    uniform_int_distribution<int>   hold(50, 500), gap(100, 1000), width(1, 3);
+    uniform_int_distribution<int>   bounces(0, o.bounces), offset(0, o.bounceMs > 1 ? o.bounceMs - 1 : 0);
+    bernoulli_distribution          glitch(o.noise / 1000);
+    ulong   now = gap(rng);
+    t.edges.clear();
+    for(int p=0; p<o.presses; p++) {
+        t.edges.push_back(now);
+        now += hold(rng);
+        t.edges.push_back(now);
+        now += gap(rng);
+    }
+    t.level.assign(now, false);
+    for(size_t e=0; e<t.edges.size(); e+=2)
+        fill(t.level.begin() + t.edges[e], t.level.begin() + t.edges[e+1], true);
+    vector<bool>    bouncing(now, false);   // inside a bounce window
+    for(size_t e=0; e<t.edges.size(); e++) {
+        ulong   end = min(now, t.edges[e] + o.bounceMs);
+        bool    was = !(e & 1);             // level before the edge
+        fill(bouncing.begin() + t.edges[e], bouncing.begin() + end, true);
+        for(int b=bounces(rng); b>0; b--) {
+            ulong at = t.edges[e] + offset(rng);
+            for(ulong ms = at; ms < at + width(rng) && ms < end; ms++)
+                t.level[ms] = was;
+        }
+    }
+    for(ulong ms=0; ms<now; ms++)
+        if(!bouncing[ms] && glitch(rng)) {
+            bool was = t.level[ms];
+            for(ulong w = ms + width(rng); ms < w && ms < now && !bouncing[ms]; ms++)
+                t.level[ms] = !was;
+        }
+}
+
+/*
+ * The input under test notes each change of its settled state. It runs
+ * the Digital state machine with a direct callback, in any build.
+ */
+class Recorder:
+    public efl::StaticDigital<Recorder>
+{
+public:
+    vector<ulong>   at;     // ms of each settled change, rising first
+    bool            on;
+    Recorder(int d):
+        efl::StaticDigital<Recorder>(1, BIT_2, d),on(false) {
+    };
+    bool callback(ulong late, States newState, States oldState) {
+        if((newState == ACTIVE) != on) {
+            on = !on;
+            at.push_back(millis());
+        }
+        return true;
+    };
+};
+
+struct Result {             // per debounce setting
+    ulong           edges;
+    ulong           detected;
+    ulong           missed;
+    ulong           falses;
+    vector<ulong>   latency;
+    Result(): edges(0),detected(0),missed(0),falses(0) {
+    };
+    void merge(const Result& r) {
+        edges += r.edges;
+        detected += r.detected;
+        missed += r.missed;
+        falses += r.falses;
+        latency.insert(latency.end(), r.latency.begin(), r.latency.end());
+    };
+};
+
+/*
+ * Each true edge owns the time until the next one. The first detected
+ * change in its direction within that time is a detection, any other
+ * change is a false trigger, and no detection is a miss.
+ */
+void score(const Trace& t, const vector<ulong>& at, Result& r)
+{
+    size_t  d = 0;
+    for(; d < at.size() && at[d] < t.edges[0]; d++)
+        r.falses++;
+    for(size_t e=0; e<t.edges.size(); e++) {
+        ulong   end = e + 1 < t.edges.size() ? t.edges[e+1] : t.level.size() + 1000;
+        bool    hit = false;
+        r.edges++;
+        for(; d < at.size() && at[d] < end; d++)
+            if(!hit && (d & 1) == (e & 1)) {
+                hit = true;
+                r.detected++;
+                r.latency.push_back(at[d] - t.edges[e]);
+            }
+            else
+                r.falses++;
+        if(!hit)
+            r.missed++;
+    }
+}
+
+void replay(const Trace& t, int debounce, Result& r)
+{
+    efl::List<Recorder>         list;
+    Recorder                    input(debounce);
+    efl::LL<Recorder>           node(&input);
+    level = false;
+    millisVal = 0;
+    node.add(list);
+    ulong end = t.level.size() + 1000;      // settle after the trace
+    while(++millisVal < end) {
+        level = millisVal < t.level.size() && t.level[millisVal];
+        list.doItems(millisVal);
+    }
+    node.erase(list);
+    score(t, input.at, r);
+}
+
+void worker(const Options& o, atomic<int>& next, vector<Result>& results, mutex& lock)
+{
+    vector<Result>  mine(o.debounce.size());
+    Trace           t;
+    for(int trial; (trial = next++) < o.trials; ) {
+        generate(o, trial, t);
+        for(size_t s=0; s<o.debounce.size(); s++)
+            replay(t, o.debounce[s], mine[s]);
+    }
+    lock_guard<mutex> l(lock);
+    for(size_t s=0; s<o.debounce.size(); s++)
+        results[s].merge(mine[s]);
+}
+
+ulong percentile(vector<ulong>& v, int p)
+{
+    if(v.empty())
+        return 0;
+    size_t i = (v.size() - 1) * p / 100;
+    nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+}
+
+void usage()
+{
+    printf("debounceMC [-t trials] [-p presses] [-b bounces] [-w bounce ms]\n"
+           "           [-n glitches/s] [-d ms,ms,...] [-s seed] [-j threads] [-c]\n"
+           "  -c prints CSV\n");
+}
+
+int main(int argc, char* argv[])
+{
+    Options     o;
+    unsigned    threads = thread::hardware_concurrency();
+    o.trials = 1000;
+    o.presses = 10;
+    o.bounces = 5;
+    o.bounceMs = 10;
+    o.noise = 0.5;
+    o.seed = 1;
+    o.csv = false;
+    const char* settings = "1,2,5,10,20,50";
+    for(int c; (c = getopt(argc, argv, "t:p:b:w:n:d:s:j:ch")) != -1; )
+        switch(c) {
+        case 't': o.trials = atoi(optarg); break;
+        case 'p': o.presses = atoi(optarg); break;
+        case 'b': o.bounces = atoi(optarg); break;
+        case 'w': o.bounceMs = atoi(optarg); break;
+        case 'n': o.noise = atof(optarg); break;
+        case 'd': settings = optarg; break;
+        case 's': o.seed = strtoul(optarg, 0, 10); break;
+        case 'j': threads = atoi(optarg); break;
+        case 'c': o.csv = true; break;
+        default: usage(); return c == 'h' ? 0 : 1;
+        }
+    for(const char* p = settings; *p; ) {
+        o.debounce.push_back(atoi(p));
+        p += strcspn(p, ",");
+        p += *p == ',';
+    }
+    if(o.trials < 1 || o.presses < 1 || o.debounce.empty()) {
+        usage();
+        return 1;
+    }
+    if(!threads)
+        threads = 1;
+
+    vector<Result>  results(o.debounce.size());
+    atomic<int>     next(0);
+    mutex           lock;
+    vector<thread>  pool;
+    for(unsigned i=0; i<threads; i++)
+        pool.push_back(thread(worker, cref(o), ref(next), ref(results), ref(lock)));
+    for(unsigned i=0; i<threads; i++)
+        pool[i].join();
+
+    if(o.csv)
+        printf("debounce,edges,detected,missed,false,latency_p50,latency_p99,latency_max\n");
+    else
+        printf("%d trials of %d presses, up to %d bounces in %d ms, %.2f glitches/s\n"
+               "debounce    edges detected   missed    false  latency p50  p99  max\n",
+               o.trials, o.presses, o.bounces, o.bounceMs, o.noise);
+    for(size_t s=0; s<o.debounce.size(); s++) {
+        Result& r = results[s];
+        ulong   p50 = percentile(r.latency, 50), p99 = percentile(r.latency, 99);
+        ulong   max = r.latency.empty() ? 0 : *max_element(r.latency.begin(), r.latency.end());
+        printf(o.csv ? "%d,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n" : "%8d %8lu %8lu %8lu %8lu %12lu %4lu %4lu\n",
+               o.debounce[s], r.edges, r.detected, r.missed, r.falses, p50, p99, max);
+    }
+    return 0;
+}